@@ -0,0 +1,168 @@
+#include <math.h>
+#include "accuracy.h"
+
+// RECURSIVE OSCILLATOR -------------------------------------------------------------------------------------------------
+void RECURSIVE_OSCILLATOR_init(RECURSIVE_OSCILLATOR *oscillator, double frequency, double phase_offset,
+                               double sample_rate) {
+    double step = 2 * M_PI * frequency / sample_rate;
+    oscillator->frequency = frequency;
+    oscillator->phase_offset = phase_offset;
+    oscillator->sample_period = 1.0 / sample_rate;
+    oscillator->last_time = 0.0;
+    oscillator->step_cos = cos(step);
+    oscillator->step_sin = sin(step);
+    oscillator->in_phase = cos(phase_offset);
+    oscillator->quadrature = sin(phase_offset);
+    oscillator->until_renormalize = OSCILLATOR_RENORMALIZE_INTERVAL;
+    oscillator->until_anchor = 0;
+}
+
+// cos and sin of 2 * pi * frequency * time + phase_offset for n samples, samples evenly spaced at the sample rate are
+// produced by rotation, the others are anchored
+void RECURSIVE_OSCILLATOR_generate(RECURSIVE_OSCILLATOR *oscillator, const double *time, int n, double *in_phase,
+                                   double *quadrature) {
+    double c = oscillator->in_phase, s = oscillator->quadrature;
+    double tolerance = OSCILLATOR_SPACING_TOLERANCE * oscillator->sample_period;
+    for (int k = 0; k < n; k++) {
+        if (fabs(time[k] - oscillator->last_time - oscillator->sample_period) > tolerance) {
+            oscillator->until_anchor = 0;
+        }
+        oscillator->last_time = time[k];
+        if (oscillator->until_anchor == 0) {
+            double phase = 2 * M_PI * fmod(oscillator->frequency * time[k], 1.0) + oscillator->phase_offset;
+            c = cos(phase);
+            s = sin(phase);
+            oscillator->until_anchor = OSCILLATOR_ANCHOR_INTERVAL;
+            oscillator->until_renormalize = OSCILLATOR_RENORMALIZE_INTERVAL;
+        }
+        in_phase[k] = c;
+        quadrature[k] = s;
+
+        double rotated = c * oscillator->step_cos - s * oscillator->step_sin;
+        s = s * oscillator->step_cos + c * oscillator->step_sin;
+        c = rotated;
+        oscillator->until_anchor--;
+
+        // first order Newton step towards unit length, the deviation is far below its radius of convergence
+        if (--oscillator->until_renormalize == 0) {
+            double gain = 1.5 - 0.5 * (c * c + s * s);
+            c *= gain;
+            s *= gain;
+            oscillator->until_renormalize = OSCILLATOR_RENORMALIZE_INTERVAL;
+        }
+    }
+    oscillator->in_phase = c;
+    oscillator->quadrature = s;
+}
+
+// ERROR METRICS --------------------------------------------------------------------------------------------------------
+static void reset_window(ERROR_METRICS *metrics) {
+    metrics->filled = 0;
+    metrics->ss = metrics->sc = metrics->s1 = metrics->cc = metrics->c1 = 0.0;
+    metrics->ys = metrics->yc = metrics->y1 = 0.0;
+    metrics->time_sum = 0.0;
+}
+
+void ERROR_METRICS_init(ERROR_METRICS *metrics, double amplitude, double gain, double phase_shift, int window) {
+    metrics->amplitude = amplitude;
+    metrics->gain = gain;
+    metrics->phase_shift = phase_shift;
+    metrics->window = window < ERROR_METRICS_MIN_WINDOW ? ERROR_METRICS_MIN_WINDOW : window;
+    metrics->count = 0;
+    metrics->sum_squares = 0.0;
+    metrics->peak = 0.0;
+    reset_window(metrics);
+    metrics->windows = 0;
+    metrics->fit_amplitude = 0.0;
+    metrics->fit_offset = 0.0;
+    metrics->fit_phase = 0.0;
+    metrics->first_time = 0.0;
+    metrics->sum_t = metrics->sum_tt = metrics->sum_p = metrics->sum_tp = 0.0;
+}
+
+// solve the 3 x 3 normal equations by Cramer's rule, a window too short to tell sin, cos and offset apart is dropped
+static void fit_window(ERROR_METRICS *metrics) {
+    double n = metrics->filled;
+    double m00 = metrics->ss, m01 = metrics->sc, m02 = metrics->s1;
+    double m11 = metrics->cc, m12 = metrics->c1, m22 = n;
+    double r0 = metrics->ys, r1 = metrics->yc, r2 = metrics->y1;
+
+    double det = m00 * (m11 * m22 - m12 * m12) - m01 * (m01 * m22 - m12 * m02) + m02 * (m01 * m12 - m11 * m02);
+    if (fabs(det) <= 1e-12 * n * n * n) {
+        reset_window(metrics);
+        return;
+    }
+    double a = (r0 * (m11 * m22 - m12 * m12) - m01 * (r1 * m22 - m12 * r2) + m02 * (r1 * m12 - m11 * r2)) / det;
+    double b = (m00 * (r1 * m22 - m12 * r2) - r0 * (m01 * m22 - m12 * m02) + m02 * (m01 * r2 - r1 * m02)) / det;
+    double c = (m00 * (m11 * r2 - r1 * m12) - m01 * (m01 * r2 - r1 * m02) + r0 * (m01 * m12 - m11 * m02)) / det;
+
+    // a * sin + b * cos = hypot(a, b) * sin(phase + atan2(b, a)), unwrapped against the previous window
+    double phase = atan2(b, a) - metrics->phase_shift;
+    if (metrics->windows > 0) {
+        phase += 2 * M_PI * round((metrics->fit_phase - phase) / (2 * M_PI));
+    }
+    double t = metrics->time_sum / n;
+    if (metrics->windows == 0) {
+        metrics->first_time = t;
+    }
+    t -= metrics->first_time;
+
+    metrics->fit_amplitude = hypot(a, b);
+    metrics->fit_offset = c;
+    metrics->fit_phase = phase;
+    metrics->sum_t += t;
+    metrics->sum_tt += t * t;
+    metrics->sum_p += phase;
+    metrics->sum_tp += t * phase;
+    metrics->windows++;
+    reset_window(metrics);
+}
+
+// in_phase and quadrature are cos and sin of the reference phase of each sample
+void ERROR_METRICS_update(ERROR_METRICS *metrics, const double *time, const double *in_phase,
+                          const double *quadrature, const double *output, int n) {
+    // amplitude * gain * sin(phase + phase_shift) = reference_sin * sin(phase) + reference_cos * cos(phase)
+    double reference_sin = metrics->amplitude * metrics->gain * cos(metrics->phase_shift);
+    double reference_cos = metrics->amplitude * metrics->gain * sin(metrics->phase_shift);
+    for (int k = 0; k < n; k++) {
+        double s = quadrature[k], c = in_phase[k], y = output[k];
+        double error = y - (reference_sin * s + reference_cos * c);
+        metrics->sum_squares += error * error;
+        if (fabs(error) > metrics->peak) {
+            metrics->peak = fabs(error);
+        }
+
+        metrics->ss += s * s;
+        metrics->sc += s * c;
+        metrics->s1 += s;
+        metrics->cc += c * c;
+        metrics->c1 += c;
+        metrics->ys += y * s;
+        metrics->yc += y * c;
+        metrics->y1 += y;
+        metrics->time_sum += time[k];
+        if (++metrics->filled == metrics->window) {
+            fit_window(metrics);
+        }
+    }
+    metrics->count += n;
+}
+
+void ERROR_METRICS_get_report(const ERROR_METRICS *metrics, ERROR_REPORT *report) {
+    report->count = metrics->count;
+    report->rms_error = metrics->count > 0 ? sqrt(metrics->sum_squares / metrics->count) : 0.0;
+    report->peak_error = metrics->peak;
+    report->windows = metrics->windows;
+    report->amplitude = metrics->fit_amplitude;
+    report->offset = metrics->fit_offset;
+    report->phase_error = metrics->fit_phase;
+    report->frequency_error = 0.0;
+    if (metrics->windows > 1) {
+        double w = (double)metrics->windows;
+        double denominator = w * metrics->sum_tt - metrics->sum_t * metrics->sum_t;
+        if (denominator > 0.0) {
+            report->frequency_error = (w * metrics->sum_tp - metrics->sum_t * metrics->sum_p) / denominator
+                                      / (2 * M_PI);
+        }
+    }
+}
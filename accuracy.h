@@ -0,0 +1,80 @@
+#ifndef ACCURACY_H
+#define ACCURACY_H
+
+#define OSCILLATOR_RENORMALIZE_INTERVAL 64   // rotations between two amplitude corrections
+#define OSCILLATOR_ANCHOR_INTERVAL 65536     // samples between two exact evaluations of the phase
+#define OSCILLATOR_SPACING_TOLERANCE 1e-6  // relative deviation of the sample spacing that anchors the phase again
+#define ERROR_METRICS_MIN_WINDOW 16
+
+// RECURSIVE OSCILLATOR -------------------------------------------------------------------------------------------------
+// ideal reference cos/sin pair produced by rotating a phasor by a fixed angle per sample, two multiplies and two adds
+// instead of a sin call per sample. The rounding of each rotation would let the amplitude drift, so the phasor is
+// pulled back to unit length every OSCILLATOR_RENORMALIZE_INTERVAL samples, and the phase is evaluated exactly from the
+// sample time every OSCILLATOR_ANCHOR_INTERVAL samples, which also absorbs the rounding of the accumulated sample time,
+// and whenever two samples are not one sample period apart
+typedef struct {
+    double frequency;          // Hz
+    double phase_offset;       // rad
+    double sample_period;      // s
+    double last_time;          // time of the previous sample, s
+    double step_cos;           // rotation per sample
+    double step_sin;
+    double in_phase;           // cos of the phase of the next sample
+    double quadrature;         // sin of the phase of the next sample
+    int until_renormalize;     // rotations left before the next amplitude correction
+    int until_anchor;          // samples left before the phase is evaluated exactly again, 0 anchors the next one
+} RECURSIVE_OSCILLATOR;
+
+void RECURSIVE_OSCILLATOR_init(RECURSIVE_OSCILLATOR *oscillator, double frequency, double phase_offset,
+                               double sample_rate);
+void RECURSIVE_OSCILLATOR_generate(RECURSIVE_OSCILLATOR *oscillator, const double *time, int n, double *in_phase,
+                                   double *quadrature);
+
+// ERROR METRICS --------------------------------------------------------------------------------------------------------
+// online comparison of an output with the reference amplitude * gain * sin(phase + phase_shift), where gain and
+// phase_shift are the response of the path to the output at the reference frequency, e.g. of a filter: RMS and peak
+// error over all samples, and a least-squares fit output = a * sin(phase) + b * cos(phase) + c over consecutive
+// windows, whose amplitude hypot(a, b) and phase error atan2(b, a) - phase_shift are reported, a straight line through
+// the unwrapped phase errors of all windows gives the frequency error
+typedef struct {
+    double amplitude;          // of the reference, V
+    double gain;               // response of the path to the output at the reference frequency
+    double phase_shift;        // rad
+    int window;                // samples per fit
+
+    long long count;           // samples compared
+    double sum_squares;        // of the error, V^2
+    double peak;               // largest absolute error, V
+
+    // normal equations of the current window, basis sin, cos and 1
+    int filled;                // samples in the current window
+    double ss, sc, s1, cc, c1;
+    double ys, yc, y1;
+    double time_sum;           // to place the window at its mean time
+
+    // fitted windows
+    long long windows;
+    double fit_amplitude;      // of the latest window, V
+    double fit_offset;         // of the latest window, V
+    double fit_phase;          // unwrapped phase error of the latest window, rad
+    double first_time;         // mean time of the first window, s, the line is fitted in time relative to it
+    double sum_t, sum_tt, sum_p, sum_tp;
+} ERROR_METRICS;
+
+typedef struct {
+    long long count;           // samples compared
+    double rms_error;          // V
+    double peak_error;         // V
+    long long windows;         // fitted windows
+    double amplitude;          // fitted amplitude of the latest window, V
+    double offset;             // fitted offset of the latest window, V
+    double phase_error;        // of the latest window, rad
+    double frequency_error;    // output frequency minus reference frequency, Hz, 0 before two windows are fitted
+} ERROR_REPORT;
+
+void ERROR_METRICS_init(ERROR_METRICS *metrics, double amplitude, double gain, double phase_shift, int window);
+void ERROR_METRICS_update(ERROR_METRICS *metrics, const double *time, const double *in_phase,
+                          const double *quadrature, const double *output, int n);
+void ERROR_METRICS_get_report(const ERROR_METRICS *metrics, ERROR_REPORT *report);
+
+#endif // ACCURACY_H
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include "activity.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define popcount64(x) __builtin_popcountll(x)
+#else
+static int popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+#endif
+
+static const char *const node_names[ACTIVITY_NUM_NODES] = {
+    "nand_yq", "nand_y", "nand_q", "xor_yq", "nand_cx", "nand_c", "nand_x", "sum",
+    "and_yq", "and_qc", "and_yc", "or_carry", "cout", "q", "clock", "clock_idle"
+};
+
+// GATE ACTIVITY --------------------------------------------------------------------------------------------------------
+// returns 1 on success, 0 if the accumulator is wider than a packed word
+int GATE_ACTIVITY_init(GATE_ACTIVITY *activity, int n_bits) {
+    memset(activity, 0, sizeof(GATE_ACTIVITY));
+    if (n_bits < 1 || n_bits > ACTIVITY_MAX_BITS) {
+        return 0;
+    }
+    activity->n_bits = n_bits;
+    activity->mask = n_bits == 64 ? ~0ULL : (1ULL << n_bits) - 1;
+    return 1;
+}
+
+// add one to the bit-sliced counter of every bit set in word
+static void counter_add(uint64_t *planes, uint64_t word) {
+    for (int p = 0; word != 0 && p < ACTIVITY_COUNTER_BITS; p++) {
+        uint64_t carry = planes[p] & word;
+        planes[p] ^= word;
+        word = carry;
+    }
+}
+
+// move the bit-sliced counters into the per bit counts
+static void flush(GATE_ACTIVITY *activity) {
+    for (int node = 0; node < ACTIVITY_NUM_NODES; node++) {
+        for (int p = 0; p < ACTIVITY_COUNTER_BITS; p++) {
+            uint64_t plane = activity->planes[node][p];
+            while (plane != 0) {
+                int bit = popcount64((plane & (~plane + 1)) - 1);  // index of lowest set bit
+                activity->counts[node][bit] += 1LL << p;
+                plane &= plane - 1;
+            }
+            activity->planes[node][p] = 0;
+        }
+    }
+    activity->pending = 0;
+}
+
+static void count(GATE_ACTIVITY *activity, ACTIVITY_NODE node, uint64_t toggled) {
+    activity->totals[node] += popcount64(toggled);
+    counter_add(activity->planes[node], toggled);
+}
+
+// one evaluation of the accumulator, bit i of each word belongs to one-bit accumulator i: y is the tuning word input,
+// q the flip-flop outputs feeding the adders, cin the carry into each bit, q_next the flip-flop outputs afterwards and
+// rising_edge the flip-flops that saw a rising clock edge
+void GATE_ACTIVITY_update(GATE_ACTIVITY *activity, uint64_t y, uint64_t q, uint64_t cin, uint64_t q_next,
+                          uint64_t rising_edge) {
+    uint64_t nets[ACTIVITY_NUM_GATES];
+
+    // xor(y, Q) of four NAND gates
+    nets[ACTIVITY_NAND_YQ] = ~(y & q);
+    nets[ACTIVITY_NAND_Y] = ~(y & nets[ACTIVITY_NAND_YQ]);
+    nets[ACTIVITY_NAND_Q] = ~(q & nets[ACTIVITY_NAND_YQ]);
+    nets[ACTIVITY_XOR_YQ] = ~(nets[ACTIVITY_NAND_Y] & nets[ACTIVITY_NAND_Q]);
+
+    // xor(Cin, xor(y, Q))
+    nets[ACTIVITY_NAND_CX] = ~(cin & nets[ACTIVITY_XOR_YQ]);
+    nets[ACTIVITY_NAND_C] = ~(cin & nets[ACTIVITY_NAND_CX]);
+    nets[ACTIVITY_NAND_X] = ~(nets[ACTIVITY_XOR_YQ] & nets[ACTIVITY_NAND_CX]);
+    nets[ACTIVITY_SUM] = ~(nets[ACTIVITY_NAND_C] & nets[ACTIVITY_NAND_X]);
+
+    // carry out
+    nets[ACTIVITY_AND_YQ] = y & q;
+    nets[ACTIVITY_AND_QC] = q & cin;
+    nets[ACTIVITY_AND_YC] = y & cin;
+    nets[ACTIVITY_OR_CARRY] = nets[ACTIVITY_AND_YQ] | nets[ACTIVITY_AND_QC];
+    nets[ACTIVITY_COUT] = nets[ACTIVITY_OR_CARRY] | nets[ACTIVITY_AND_YC];
+
+    nets[ACTIVITY_Q] = q_next;
+
+    for (int node = 0; node < ACTIVITY_NUM_GATES; node++) {
+        nets[node] &= activity->mask;
+        if (activity->initialized) {
+            uint64_t toggled = nets[node] ^ activity->state[node];
+            if (toggled != 0) {
+                count(activity, (ACTIVITY_NODE)node, toggled);
+            }
+        }
+        activity->state[node] = nets[node];
+    }
+
+    rising_edge &= activity->mask;
+    if (rising_edge != 0) {
+        count(activity, ACTIVITY_CLOCK, rising_edge);
+        uint64_t idle = rising_edge & ~(q ^ q_next);
+        if (idle != 0) {
+            count(activity, ACTIVITY_CLOCK_IDLE, idle);
+        }
+    }
+
+    activity->initialized = 1;
+    activity->evaluations++;
+    if (++activity->pending == (1LL << ACTIVITY_COUNTER_BITS) - 1) {
+        flush(activity);
+    }
+}
+
+// toggles of a net in one bit, including those not yet flushed from the bit-sliced counters
+long long GATE_ACTIVITY_count(const GATE_ACTIVITY *activity, ACTIVITY_NODE node, int bit) {
+    long long count = activity->counts[node][bit];
+    for (int p = 0; p < ACTIVITY_COUNTER_BITS; p++) {
+        count += (long long)((activity->planes[node][p] >> bit) & 1) << p;
+    }
+    return count;
+}
+
+const char *GATE_ACTIVITY_node_name(ACTIVITY_NODE node) {
+    return node >= 0 && node < ACTIVITY_NUM_NODES ? node_names[node] : "unknown";
+}
+
+// write toggles and activity factor (toggles per clock cycle per bit) of every net, followed by the toggles of every
+// net per bit, the two tables are separate gnuplot data blocks, returns the number of bit rows written, -1 if the file
+// cannot be opened
+int GATE_ACTIVITY_export(const GATE_ACTIVITY *activity, const char *filename, const char *title) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        return -1;
+    }
+
+    long long cycles = activity->n_bits > 0 ? activity->totals[ACTIVITY_CLOCK] / activity->n_bits : 0;
+    fprintf(file, "# %s\n", title);
+    fprintf(file, "# bits = %d, evaluations = %lld, clock cycles = %lld\n",
+            activity->n_bits, activity->evaluations, cycles);
+
+    long long gate_total = 0;
+    fprintf(file, "# net\ttoggles\tactivity\n");
+    for (int node = 0; node < ACTIVITY_NUM_NODES; node++) {
+        double factor = cycles > 0 ? (double)activity->totals[node] / ((double)cycles * activity->n_bits) : 0.0;
+        fprintf(file, "%s\t%lld\t%.6f\n", node_names[node], activity->totals[node], factor);
+        if (node < ACTIVITY_NUM_GATES) gate_total += activity->totals[node];
+    }
+    fprintf(file, "gates\t%lld\t%.6f\n", gate_total,
+            cycles > 0 ? (double)gate_total / ((double)cycles * activity->n_bits) : 0.0);
+
+    // per bit, bit 0 is the LSB
+    fprintf(file, "\n\n# bit");
+    for (int node = 0; node < ACTIVITY_NUM_NODES; node++) {
+        fprintf(file, "\t%s", node_names[node]);
+    }
+    fprintf(file, "\tgates\n");
+    for (int bit = 0; bit < activity->n_bits; bit++) {
+        long long bit_total = 0;
+        fprintf(file, "%d", bit);
+        for (int node = 0; node < ACTIVITY_NUM_NODES; node++) {
+            long long count = GATE_ACTIVITY_count(activity, (ACTIVITY_NODE)node, bit);
+            fprintf(file, "\t%lld", count);
+            if (node < ACTIVITY_NUM_GATES) bit_total += count;
+        }
+        fprintf(file, "\t%lld\n", bit_total);
+    }
+
+    fclose(file);
+    return activity->n_bits;
+}
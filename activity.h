@@ -0,0 +1,53 @@
+#ifndef ACTIVITY_H
+#define ACTIVITY_H
+#include <stdint.h>
+
+#define ACTIVITY_MAX_BITS 64      // one-bit accumulators covered by one packed word
+#define ACTIVITY_COUNTER_BITS 16  // depth of the bit-sliced toggle counters, flushed before they can overflow
+
+// nets of one ONE_BIT_ACCUMULATOR, the full adder is xor(Cin, xor(y, Q)) of NAND gates plus the carry logic
+typedef enum {
+    ACTIVITY_NAND_YQ,             // nand(y, Q) of first xor
+    ACTIVITY_NAND_Y,              // nand(y, nand(y, Q))
+    ACTIVITY_NAND_Q,              // nand(Q, nand(y, Q))
+    ACTIVITY_XOR_YQ,              // output of first xor
+    ACTIVITY_NAND_CX,             // nand(Cin, xor(y, Q)) of second xor
+    ACTIVITY_NAND_C,              // nand(Cin, nand(Cin, xor))
+    ACTIVITY_NAND_X,              // nand(xor, nand(Cin, xor))
+    ACTIVITY_SUM,                 // output of second xor, D input of flip-flop
+    ACTIVITY_AND_YQ,              // y && Q
+    ACTIVITY_AND_QC,              // Q && Cin
+    ACTIVITY_AND_YC,              // y && Cin
+    ACTIVITY_OR_CARRY,            // (y && Q) || (Q && Cin)
+    ACTIVITY_COUT,                // carry out to the higher bit
+    ACTIVITY_Q,                   // flip-flop output
+    ACTIVITY_NUM_GATES,
+    ACTIVITY_CLOCK = ACTIVITY_NUM_GATES, // rising clock edges seen by the flip-flop
+    ACTIVITY_CLOCK_IDLE,          // rising clock edges that left Q unchanged, i.e. could have been gated
+    ACTIVITY_NUM_NODES
+} ACTIVITY_NODE;
+
+// GATE ACTIVITY --------------------------------------------------------------------------------------------------------
+// toggle counters of every net of an N-bit accumulator, the nets of all bits are held in one word per net so that an
+// evaluation costs a few word operations, toggles are counted per net with popcount and per bit in bit-sliced counters
+// zero-delay model, glitches while the carry ripples are not counted
+typedef struct {
+    int n_bits;
+    uint64_t mask;                     // bits in use
+    int initialized;                   // whether the first evaluation has been seen
+    long long evaluations;             // number of accumulator evaluations
+    long long pending;                 // evaluations held in the bit-sliced counters
+    uint64_t state[ACTIVITY_NUM_GATES];// net values of the previous evaluation, bit i belongs to one-bit accumulator i
+    uint64_t planes[ACTIVITY_NUM_NODES][ACTIVITY_COUNTER_BITS]; // plane p holds bit p of the counter of every bit
+    long long totals[ACTIVITY_NUM_NODES];                       // toggles of each net over all bits
+    long long counts[ACTIVITY_NUM_NODES][ACTIVITY_MAX_BITS];    // flushed toggles of each net per bit
+} GATE_ACTIVITY;
+
+int GATE_ACTIVITY_init(GATE_ACTIVITY *activity, int n_bits);
+void GATE_ACTIVITY_update(GATE_ACTIVITY *activity, uint64_t y, uint64_t q, uint64_t cin, uint64_t q_next,
+                          uint64_t rising_edge);
+long long GATE_ACTIVITY_count(const GATE_ACTIVITY *activity, ACTIVITY_NODE node, int bit);
+const char *GATE_ACTIVITY_node_name(ACTIVITY_NODE node);
+int GATE_ACTIVITY_export(const GATE_ACTIVITY *activity, const char *filename, const char *title);
+
+#endif // ACTIVITY_H
@@ -0,0 +1,832 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "checkpoint.h"
+
+// error receives message unless it is NULL, returns 0 for the caller to pass on
+static int get_failed(const char **error, const char *message) {
+    if (error != NULL) {
+        *error = message;
+    }
+    return 0;
+}
+
+// CHECKPOINT BUFFER ----------------------------------------------------------------------------------------------------
+void CHECKPOINT_BUFFER_init(CHECKPOINT_BUFFER *buffer) {
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+    buffer->position = 0;
+    buffer->error = 0;
+}
+
+// forget the content but keep the allocation for the next checkpoint
+void CHECKPOINT_BUFFER_reset(CHECKPOINT_BUFFER *buffer) {
+    buffer->size = 0;
+    buffer->position = 0;
+    buffer->error = 0;
+}
+
+void CHECKPOINT_BUFFER_cleanup(CHECKPOINT_BUFFER *buffer) {
+    free(buffer->data);
+    CHECKPOINT_BUFFER_init(buffer);
+}
+
+void CHECKPOINT_put_bytes(CHECKPOINT_BUFFER *buffer, const void *bytes, size_t size) {
+    if (buffer->error) return;
+
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+        while (capacity < buffer->size + size) {
+            capacity *= 2;
+        }
+        unsigned char *data = (unsigned char *)realloc(buffer->data, capacity);
+        if (data == NULL) {
+            buffer->error = 1;
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->size, bytes, size);
+    buffer->size += size;
+}
+
+void CHECKPOINT_put_u64(CHECKPOINT_BUFFER *buffer, uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));  // little-endian regardless of host
+    }
+    CHECKPOINT_put_bytes(buffer, bytes, 8);
+}
+
+void CHECKPOINT_put_int(CHECKPOINT_BUFFER *buffer, long long value) {
+    CHECKPOINT_put_u64(buffer, (uint64_t)value);
+}
+
+void CHECKPOINT_put_double(CHECKPOINT_BUFFER *buffer, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));  // bit pattern, so restored values are exact
+    CHECKPOINT_put_u64(buffer, bits);
+}
+
+void CHECKPOINT_put_string(CHECKPOINT_BUFFER *buffer, const char *string) {
+    size_t length = strlen(string);
+    CHECKPOINT_put_u64(buffer, length);
+    CHECKPOINT_put_bytes(buffer, string, length);
+}
+
+void CHECKPOINT_get_bytes(CHECKPOINT_BUFFER *buffer, void *bytes, size_t size) {
+    if (buffer->error || buffer->position + size > buffer->size) {
+        buffer->error = 1;
+        memset(bytes, 0, size);
+        return;
+    }
+    memcpy(bytes, buffer->data + buffer->position, size);
+    buffer->position += size;
+}
+
+uint64_t CHECKPOINT_get_u64(CHECKPOINT_BUFFER *buffer) {
+    unsigned char bytes[8];
+    CHECKPOINT_get_bytes(buffer, bytes, 8);
+
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+long long CHECKPOINT_get_int(CHECKPOINT_BUFFER *buffer) {
+    return (long long)CHECKPOINT_get_u64(buffer);
+}
+
+double CHECKPOINT_get_double(CHECKPOINT_BUFFER *buffer) {
+    uint64_t bits = CHECKPOINT_get_u64(buffer);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// string is truncated to size - 1 characters if it does not fit, which is reported as an error
+void CHECKPOINT_get_string(CHECKPOINT_BUFFER *buffer, char *string, size_t size) {
+    uint64_t length = CHECKPOINT_get_u64(buffer);
+    if (buffer->error || length >= size || buffer->position + length > buffer->size) {
+        buffer->error = 1;
+        if (size > 0) string[0] = '\0';
+        return;
+    }
+    CHECKPOINT_get_bytes(buffer, string, length);
+    string[length] = '\0';
+}
+
+// FNV-1a hash, detects truncated or corrupted checkpoint files
+static uint64_t checksum(const unsigned char *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void CHECKPOINT_begin(CHECKPOINT_BUFFER *buffer) {
+    CHECKPOINT_BUFFER_reset(buffer);
+    CHECKPOINT_put_bytes(buffer, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    CHECKPOINT_put_u64(buffer, CHECKPOINT_VERSION);
+}
+
+void CHECKPOINT_end(CHECKPOINT_BUFFER *buffer) {
+    if (buffer->error) return;
+    CHECKPOINT_put_u64(buffer, checksum(buffer->data, buffer->size));
+}
+
+// read a checkpoint file and position the read cursor after its header, returns 1 on success, error receives the reason
+// of a failure unless it is NULL
+int CHECKPOINT_load(CHECKPOINT_BUFFER *buffer, const char *filename, const char **error) {
+    CHECKPOINT_BUFFER_reset(buffer);
+
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return get_failed(error, "Unable to open checkpoint file");
+    }
+
+    unsigned char chunk[65536];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        CHECKPOINT_put_bytes(buffer, chunk, count);
+    }
+    fclose(file);
+
+    size_t header_size = sizeof(CHECKPOINT_MAGIC) + 8;
+    if (buffer->error || buffer->size < header_size + 8
+        || memcmp(buffer->data, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        return get_failed(error, "Not a checkpoint file");
+    }
+
+    // trailer is excluded from the readable payload
+    size_t payload_size = buffer->size - 8;
+    buffer->position = payload_size;
+    uint64_t stored_checksum = CHECKPOINT_get_u64(buffer);
+    if (stored_checksum != checksum(buffer->data, payload_size)) {
+        return get_failed(error, "Checkpoint file is corrupted");
+    }
+    buffer->size = payload_size;
+
+    buffer->position = sizeof(CHECKPOINT_MAGIC);
+    uint64_t version = CHECKPOINT_get_u64(buffer);
+    if (version != CHECKPOINT_VERSION) {
+        return get_failed(error, "Checkpoint version is not supported");
+    }
+
+    return 1;
+}
+
+// read the first size bytes of a journal file, returns 1 on success
+int CHECKPOINT_load_journal(CHECKPOINT_BUFFER *buffer, const char *filename, int64_t size, const char **error) {
+    CHECKPOINT_BUFFER_reset(buffer);
+    if (size < 0 || (uint64_t)size > SIZE_MAX) {
+        return get_failed(error, "Journal file does not fit into memory");
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return get_failed(error, "Unable to open journal file");
+    }
+
+    unsigned char chunk[65536];
+    size_t count;
+    while (buffer->size < (size_t)size && (count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        CHECKPOINT_put_bytes(buffer, chunk, count);
+    }
+    fclose(file);
+
+    if (buffer->error || buffer->size < (size_t)size) {
+        return get_failed(error, "Journal file is shorter than its checkpoint");
+    }
+    buffer->size = (size_t)size;  // later records belong to a checkpoint that was never written
+    return 1;
+}
+
+// SIMULATION STATE -----------------------------------------------------------------------------------------------------
+// phase register, frequency tuning word and the flip-flop state of every bit of the phase accumulator
+void CHECKPOINT_put_nco(CHECKPOINT_BUFFER *buffer, const NUMERICALLY_CONTROLLED_OSCILLATOR *nco) {
+    CHECKPOINT_put_int(buffer, nco->f_MCLK);
+    CHECKPOINT_put_int(buffer, nco->N);
+    CHECKPOINT_put_string(buffer, nco->phase_register);
+    CHECKPOINT_put_string(buffer, nco->delta_Phase);
+
+    const N_BIT_ACCUMULATOR *accumulator = &nco->n_bit_accumulator;
+    CHECKPOINT_put_int(buffer, accumulator->logic_id);
+    CHECKPOINT_put_int(buffer, accumulator->n_bits);
+    for (int i = 0; i < accumulator->n_bits; i++) {
+        const ONE_BIT_ACCUMULATOR *bit = &accumulator->one_bit_accumulators[i];
+        CHECKPOINT_put_int(buffer, bit->logic_id);
+        CHECKPOINT_put_int(buffer, bit->Q);
+        CHECKPOINT_put_int(buffer, bit->nQ);
+        CHECKPOINT_put_int(buffer, bit->dflipflop.logic_id);
+        CHECKPOINT_put_int(buffer, bit->dflipflop.clock_last_state);
+        CHECKPOINT_put_int(buffer, bit->dflipflop.rising_edge);
+        CHECKPOINT_put_int(buffer, bit->dflipflop.Q);
+    }
+}
+
+// nco must already be initialized with the same bit depth, returns 1 on success
+int CHECKPOINT_get_nco(CHECKPOINT_BUFFER *buffer, NUMERICALLY_CONTROLLED_OSCILLATOR *nco, const char **error) {
+    int f_MCLK = (int)CHECKPOINT_get_int(buffer);
+    int N = (int)CHECKPOINT_get_int(buffer);
+    if (buffer->error || f_MCLK != nco->f_MCLK || N != nco->N) {
+        return get_failed(error, "Checkpoint NCO bit depth or clock does not match");
+    }
+
+    CHECKPOINT_get_string(buffer, nco->phase_register, nco->N + 1);
+    CHECKPOINT_get_string(buffer, nco->delta_Phase, nco->N + 1);
+
+    N_BIT_ACCUMULATOR *accumulator = &nco->n_bit_accumulator;
+    accumulator->logic_id = (int)CHECKPOINT_get_int(buffer);
+    if (CHECKPOINT_get_int(buffer) != accumulator->n_bits) {
+        buffer->error = 1;
+        return get_failed(error, "Checkpoint phase accumulator width does not match");
+    }
+    for (int i = 0; i < accumulator->n_bits; i++) {
+        ONE_BIT_ACCUMULATOR *bit = &accumulator->one_bit_accumulators[i];
+        bit->logic_id = (int)CHECKPOINT_get_int(buffer);
+        bit->Q = (int)CHECKPOINT_get_int(buffer);
+        bit->nQ = (int)CHECKPOINT_get_int(buffer);
+        bit->dflipflop.logic_id = (int)CHECKPOINT_get_int(buffer);
+        bit->dflipflop.clock_last_state = (int)CHECKPOINT_get_int(buffer);
+        bit->dflipflop.rising_edge = (int)CHECKPOINT_get_int(buffer);
+        bit->dflipflop.Q = (int)CHECKPOINT_get_int(buffer);
+    }
+
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+void CHECKPOINT_put_comparator(CHECKPOINT_BUFFER *buffer, const COMPARATOR *comparator) {
+    CHECKPOINT_put_double(buffer, comparator->threshold);
+    CHECKPOINT_put_double(buffer, comparator->hysteresis);
+    CHECKPOINT_put_int(buffer, comparator->state);
+    CHECKPOINT_put_int(buffer, comparator->initialized);
+    CHECKPOINT_put_double(buffer, comparator->last_time);
+    CHECKPOINT_put_double(buffer, comparator->last_input);
+    CHECKPOINT_put_int(buffer, comparator->sample_count);
+    CHECKPOINT_put_int(buffer, comparator->high_count);
+    CHECKPOINT_put_int(buffer, comparator->crossing_count);
+    CHECKPOINT_put_int(buffer, comparator->rising_edge_seen);
+    CHECKPOINT_put_double(buffer, comparator->last_rising_time);
+    CHECKPOINT_put_int(buffer, comparator->period_count);
+    CHECKPOINT_put_double(buffer, comparator->period_mean);
+    CHECKPOINT_put_double(buffer, comparator->period_m2);
+    CHECKPOINT_put_double(buffer, comparator->period_min);
+    CHECKPOINT_put_double(buffer, comparator->period_max);
+}
+
+void CHECKPOINT_get_comparator(CHECKPOINT_BUFFER *buffer, COMPARATOR *comparator) {
+    comparator->threshold = CHECKPOINT_get_double(buffer);
+    comparator->hysteresis = CHECKPOINT_get_double(buffer);
+    comparator->state = (int)CHECKPOINT_get_int(buffer);
+    comparator->initialized = (int)CHECKPOINT_get_int(buffer);
+    comparator->last_time = CHECKPOINT_get_double(buffer);
+    comparator->last_input = CHECKPOINT_get_double(buffer);
+    comparator->sample_count = CHECKPOINT_get_int(buffer);
+    comparator->high_count = CHECKPOINT_get_int(buffer);
+    comparator->crossing_count = CHECKPOINT_get_int(buffer);
+    comparator->rising_edge_seen = (int)CHECKPOINT_get_int(buffer);
+    comparator->last_rising_time = CHECKPOINT_get_double(buffer);
+    comparator->period_count = CHECKPOINT_get_int(buffer);
+    comparator->period_mean = CHECKPOINT_get_double(buffer);
+    comparator->period_m2 = CHECKPOINT_get_double(buffer);
+    comparator->period_min = CHECKPOINT_get_double(buffer);
+    comparator->period_max = CHECKPOINT_get_double(buffer);
+}
+
+// the pending buckets and the number of completed ones, whose content goes to the journal, so that the size of a
+// checkpoint does not grow with the length of the run
+void CHECKPOINT_put_envelope(CHECKPOINT_BUFFER *buffer, const ENVELOPE_PYRAMID *pyramid) {
+    CHECKPOINT_put_int(buffer, pyramid->base_size);
+    CHECKPOINT_put_int(buffer, pyramid->factor);
+    CHECKPOINT_put_int(buffer, pyramid->num_levels);
+    CHECKPOINT_put_int(buffer, pyramid->sample_count);
+    CHECKPOINT_put_int(buffer, pyramid->dropped);
+
+    for (int i = 0; i < pyramid->num_levels; i++) {
+        const ENVELOPE_LEVEL *level = &pyramid->levels[i];
+        CHECKPOINT_put_int(buffer, level->bucket_size);
+        CHECKPOINT_put_int(buffer, level->count);
+        CHECKPOINT_put_int(buffer, level->pending_children);
+        CHECKPOINT_put_double(buffer, level->pending_time);
+        CHECKPOINT_put_double(buffer, level->pending_min);
+        CHECKPOINT_put_double(buffer, level->pending_max);
+        CHECKPOINT_put_double(buffer, level->pending_sum);
+    }
+}
+
+// pyramid is replaced by the stored one with room for its completed buckets, which are filled in from the journal by
+// CHECKPOINT_get_envelope_journal, returns 1 on success
+int CHECKPOINT_get_envelope(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramid, const char **error) {
+    int base_size = (int)CHECKPOINT_get_int(buffer);
+    int factor = (int)CHECKPOINT_get_int(buffer);
+    int num_levels = (int)CHECKPOINT_get_int(buffer);
+    long long sample_count = CHECKPOINT_get_int(buffer);
+    long long dropped = CHECKPOINT_get_int(buffer);
+    if (buffer->error || num_levels < 1 || num_levels > ENVELOPE_MAX_LEVELS) {
+        buffer->error = 1;
+        return get_failed(error, "Checkpoint envelope is corrupted");
+    }
+
+    ENVELOPE_PYRAMID_cleanup(pyramid);
+    ENVELOPE_PYRAMID_init(pyramid, base_size, factor);
+    pyramid->num_levels = num_levels;
+    pyramid->sample_count = sample_count;
+    pyramid->dropped = dropped;
+
+    for (int i = 0; i < num_levels; i++) {
+        ENVELOPE_LEVEL *level = &pyramid->levels[i];
+        level->bucket_size = CHECKPOINT_get_int(buffer);
+        long long count = CHECKPOINT_get_int(buffer);
+        level->pending_children = (int)CHECKPOINT_get_int(buffer);
+        level->pending_time = CHECKPOINT_get_double(buffer);
+        level->pending_min = CHECKPOINT_get_double(buffer);
+        level->pending_max = CHECKPOINT_get_double(buffer);
+        level->pending_sum = CHECKPOINT_get_double(buffer);
+        if (buffer->error || count < 0 || count > (1LL << 40)) {
+            buffer->error = 1;
+            return get_failed(error, "Checkpoint envelope is corrupted");
+        }
+
+        if (count > 0) {
+            level->time = (double *)malloc(count * sizeof(double));
+            level->min = (double *)malloc(count * sizeof(double));
+            level->max = (double *)malloc(count * sizeof(double));
+            level->sum = (double *)malloc(count * sizeof(double));
+            if (level->time == NULL || level->min == NULL || level->max == NULL || level->sum == NULL) {
+                buffer->error = 1;
+                return get_failed(error, "Memory allocation failed for envelope level");
+            }
+            level->capacity = count;
+        }
+        level->count = 0;
+        level->journaled = count;
+    }
+
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+// append the buckets completed since the last call as (id, level, time, min, max, sum) records, id tells the
+// pyramids sharing a journal apart
+void CHECKPOINT_put_envelope_journal(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramid, int id) {
+    for (int i = 0; i < pyramid->num_levels; i++) {
+        ENVELOPE_LEVEL *level = &pyramid->levels[i];
+        for (long long j = level->journaled; j < level->count; j++) {
+            CHECKPOINT_put_int(buffer, id);
+            CHECKPOINT_put_int(buffer, i);
+            CHECKPOINT_put_double(buffer, level->time[j]);
+            CHECKPOINT_put_double(buffer, level->min[j]);
+            CHECKPOINT_put_double(buffer, level->max[j]);
+            CHECKPOINT_put_double(buffer, level->sum[j]);
+        }
+        level->journaled = level->count;
+    }
+}
+
+// refill the completed buckets of pyramids restored by CHECKPOINT_get_envelope, pyramids[id] receives the records of
+// that id, returns 1 if every level got all of its buckets
+int CHECKPOINT_get_envelope_journal(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramids, int num_pyramids,
+                                    const char **error) {
+    while (!buffer->error && buffer->position < buffer->size) {
+        long long id = CHECKPOINT_get_int(buffer);
+        long long index = CHECKPOINT_get_int(buffer);
+        double time = CHECKPOINT_get_double(buffer);
+        double min = CHECKPOINT_get_double(buffer);
+        double max = CHECKPOINT_get_double(buffer);
+        double sum = CHECKPOINT_get_double(buffer);
+        if (buffer->error || id < 0 || id >= num_pyramids || index < 0 || index >= pyramids[id].num_levels) {
+            buffer->error = 1;
+            break;
+        }
+
+        ENVELOPE_LEVEL *level = &pyramids[id].levels[index];
+        if (level->count < level->journaled) {
+            level->time[level->count] = time;
+            level->min[level->count] = min;
+            level->max[level->count] = max;
+            level->sum[level->count] = sum;
+            level->count++;
+        }
+    }
+
+    for (int id = 0; id < num_pyramids; id++) {
+        for (int i = 0; i < pyramids[id].num_levels; i++) {
+            if (pyramids[id].levels[i].count != pyramids[id].levels[i].journaled) {
+                buffer->error = 1;
+            }
+        }
+    }
+    if (buffer->error) {
+        return get_failed(error, "Envelope journal does not match the checkpoint");
+    }
+    return 1;
+}
+
+void CHECKPOINT_put_pyramid(CHECKPOINT_BUFFER *buffer, const ENVELOPE_PYRAMID *pyramid) {
+    CHECKPOINT_put_envelope(buffer, pyramid);
+    for (int i = 0; i < pyramid->num_levels; i++) {
+        const ENVELOPE_LEVEL *level = &pyramid->levels[i];
+        for (long long j = 0; j < level->count; j++) {
+            CHECKPOINT_put_double(buffer, level->time[j]);
+            CHECKPOINT_put_double(buffer, level->min[j]);
+            CHECKPOINT_put_double(buffer, level->max[j]);
+            CHECKPOINT_put_double(buffer, level->sum[j]);
+        }
+    }
+}
+
+// pyramid, initialized or restored before, is replaced by the stored one, returns 1 on success
+int CHECKPOINT_get_pyramid(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramid, const char **error) {
+    if (!CHECKPOINT_get_envelope(buffer, pyramid, error)) {
+        return 0;
+    }
+    for (int i = 0; i < pyramid->num_levels; i++) {
+        ENVELOPE_LEVEL *level = &pyramid->levels[i];
+        if ((uint64_t)(buffer->size - buffer->position) / 32 < (uint64_t)level->journaled) {
+            return get_failed(error, "Checkpoint is truncated");
+        }
+        for (level->count = 0; level->count < level->journaled; level->count++) {
+            level->time[level->count] = CHECKPOINT_get_double(buffer);
+            level->min[level->count] = CHECKPOINT_get_double(buffer);
+            level->max[level->count] = CHECKPOINT_get_double(buffer);
+            level->sum[level->count] = CHECKPOINT_get_double(buffer);
+        }
+    }
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+static void put_q_format(CHECKPOINT_BUFFER *buffer, Q_FORMAT format) {
+    CHECKPOINT_put_int(buffer, format.integer_bits);
+    CHECKPOINT_put_int(buffer, format.fraction_bits);
+}
+
+static int get_q_format(CHECKPOINT_BUFFER *buffer, Q_FORMAT format) {
+    long long integer_bits = CHECKPOINT_get_int(buffer);
+    long long fraction_bits = CHECKPOINT_get_int(buffer);
+    return integer_bits == format.integer_bits && fraction_bits == format.fraction_bits;
+}
+
+// fixed point configuration, filter history and overflow counters
+void CHECKPOINT_put_fixed_lpf(CHECKPOINT_BUFFER *buffer, const FIXED_LPF *lpf, const FIXED_OVERFLOW_COUNTERS *counters) {
+    put_q_format(buffer, lpf->config.rom);
+    put_q_format(buffer, lpf->config.coefficient);
+    put_q_format(buffer, lpf->config.accumulator);
+    put_q_format(buffer, lpf->config.dac);
+    CHECKPOINT_put_int(buffer, lpf->config.rounding);
+    CHECKPOINT_put_int(buffer, lpf->config.overflow);
+
+    CHECKPOINT_put_int(buffer, lpf->num_sections);
+    for (int i = 0; i < lpf->num_sections; i++) {
+        for (int j = 0; j < 2; j++) {
+            CHECKPOINT_put_int(buffer, lpf->sections[i].x_history[j]);
+            CHECKPOINT_put_int(buffer, lpf->sections[i].y_history[j]);
+        }
+    }
+
+    CHECKPOINT_put_int(buffer, counters->rom);
+    CHECKPOINT_put_int(buffer, counters->coefficient);
+    CHECKPOINT_put_int(buffer, counters->accumulator);
+    CHECKPOINT_put_int(buffer, counters->dac);
+}
+
+// lpf must already be initialized with the same configuration, returns 1 on success
+int CHECKPOINT_get_fixed_lpf(CHECKPOINT_BUFFER *buffer, FIXED_LPF *lpf, FIXED_OVERFLOW_COUNTERS *counters,
+                             const char **error) {
+    int same = get_q_format(buffer, lpf->config.rom);
+    same &= get_q_format(buffer, lpf->config.coefficient);
+    same &= get_q_format(buffer, lpf->config.accumulator);
+    same &= get_q_format(buffer, lpf->config.dac);
+    same &= CHECKPOINT_get_int(buffer) == lpf->config.rounding;
+    same &= CHECKPOINT_get_int(buffer) == lpf->config.overflow;
+    same &= CHECKPOINT_get_int(buffer) == lpf->num_sections;
+    if (buffer->error || !same) {
+        return get_failed(error, "Checkpoint fixed point configuration does not match");
+    }
+
+    for (int i = 0; i < lpf->num_sections; i++) {
+        for (int j = 0; j < 2; j++) {
+            lpf->sections[i].x_history[j] = (int32_t)CHECKPOINT_get_int(buffer);
+            lpf->sections[i].y_history[j] = (int32_t)CHECKPOINT_get_int(buffer);
+        }
+    }
+
+    counters->rom = CHECKPOINT_get_int(buffer);
+    counters->coefficient = CHECKPOINT_get_int(buffer);
+    counters->accumulator = CHECKPOINT_get_int(buffer);
+    counters->dac = CHECKPOINT_get_int(buffer);
+
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+// the bit-sliced counters are stored flushed into the per bit counts
+void CHECKPOINT_put_gate_activity(CHECKPOINT_BUFFER *buffer, const GATE_ACTIVITY *activity) {
+    CHECKPOINT_put_int(buffer, activity->n_bits);
+    CHECKPOINT_put_int(buffer, activity->initialized);
+    CHECKPOINT_put_int(buffer, activity->evaluations);
+    for (int node = 0; node < ACTIVITY_NUM_GATES; node++) {
+        CHECKPOINT_put_u64(buffer, activity->state[node]);
+    }
+    for (int node = 0; node < ACTIVITY_NUM_NODES; node++) {
+        CHECKPOINT_put_int(buffer, activity->totals[node]);
+        for (int bit = 0; bit < activity->n_bits; bit++) {
+            CHECKPOINT_put_int(buffer, GATE_ACTIVITY_count(activity, (ACTIVITY_NODE)node, bit));
+        }
+    }
+}
+
+int CHECKPOINT_get_gate_activity(CHECKPOINT_BUFFER *buffer, GATE_ACTIVITY *activity, const char **error) {
+    if (CHECKPOINT_get_int(buffer) != activity->n_bits) {
+        return get_failed(error, "Checkpoint gate activity width does not match");
+    }
+    activity->initialized = (int)CHECKPOINT_get_int(buffer);
+    activity->evaluations = CHECKPOINT_get_int(buffer);
+    for (int node = 0; node < ACTIVITY_NUM_GATES; node++) {
+        activity->state[node] = CHECKPOINT_get_u64(buffer);
+    }
+    memset(activity->planes, 0, sizeof(activity->planes));
+    activity->pending = 0;
+    for (int node = 0; node < ACTIVITY_NUM_NODES; node++) {
+        activity->totals[node] = CHECKPOINT_get_int(buffer);
+        for (int bit = 0; bit < activity->n_bits; bit++) {
+            activity->counts[node][bit] = CHECKPOINT_get_int(buffer);
+        }
+    }
+
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+// filter coefficients are designed again at init, only the histories are stored
+void CHECKPOINT_put_interpolator(CHECKPOINT_BUFFER *buffer, const HALFBAND_INTERPOLATOR *interpolator) {
+    CHECKPOINT_put_int(buffer, interpolator->num_stages);
+    for (int s = 0; s < interpolator->num_stages; s++) {
+        const HALFBAND_STAGE *stage = &interpolator->stages[s];
+        CHECKPOINT_put_int(buffer, stage->num_taps);
+        for (int i = 0; i < 2 * stage->num_taps - 1; i++) {
+            CHECKPOINT_put_double(buffer, stage->history[i]);
+        }
+    }
+}
+
+int CHECKPOINT_get_interpolator(CHECKPOINT_BUFFER *buffer, HALFBAND_INTERPOLATOR *interpolator, const char **error) {
+    int same = CHECKPOINT_get_int(buffer) == interpolator->num_stages;
+    for (int s = 0; same && s < interpolator->num_stages; s++) {
+        HALFBAND_STAGE *stage = &interpolator->stages[s];
+        same &= CHECKPOINT_get_int(buffer) == stage->num_taps;
+        for (int i = 0; same && i < 2 * stage->num_taps - 1; i++) {
+            stage->history[i] = CHECKPOINT_get_double(buffer);
+        }
+    }
+    if (buffer->error || !same) {
+        return get_failed(error, "Checkpoint interpolator configuration does not match");
+    }
+    return 1;
+}
+
+void CHECKPOINT_put_decimator(CHECKPOINT_BUFFER *buffer, const CIC_DECIMATOR *decimator) {
+    CHECKPOINT_put_int(buffer, decimator->order);
+    CHECKPOINT_put_int(buffer, decimator->ratio);
+    CHECKPOINT_put_int(buffer, decimator->compensator.num_taps);
+    CHECKPOINT_put_double(buffer, decimator->pass_band);
+    CHECKPOINT_put_double(buffer, decimator->full_scale);
+    CHECKPOINT_put_int(buffer, decimator->phase);
+    for (int i = 0; i < decimator->order; i++) {
+        CHECKPOINT_put_u64(buffer, decimator->integrators[i]);
+        CHECKPOINT_put_u64(buffer, decimator->combs[i]);
+    }
+    for (int i = 0; i < decimator->compensator.num_taps - 1; i++) {
+        CHECKPOINT_put_double(buffer, decimator->compensator.history[i]);
+    }
+}
+
+int CHECKPOINT_get_decimator(CHECKPOINT_BUFFER *buffer, CIC_DECIMATOR *decimator, const char **error) {
+    int same = CHECKPOINT_get_int(buffer) == decimator->order;
+    same &= CHECKPOINT_get_int(buffer) == decimator->ratio;
+    same &= CHECKPOINT_get_int(buffer) == decimator->compensator.num_taps;
+    same &= CHECKPOINT_get_double(buffer) == decimator->pass_band;
+    same &= CHECKPOINT_get_double(buffer) == decimator->full_scale;
+    if (buffer->error || !same) {
+        return get_failed(error, "Checkpoint decimator configuration does not match");
+    }
+
+    decimator->phase = (int)CHECKPOINT_get_int(buffer);
+    for (int i = 0; i < decimator->order; i++) {
+        decimator->integrators[i] = CHECKPOINT_get_u64(buffer);
+        decimator->combs[i] = CHECKPOINT_get_u64(buffer);
+    }
+    for (int i = 0; i < decimator->compensator.num_taps - 1; i++) {
+        decimator->compensator.history[i] = CHECKPOINT_get_double(buffer);
+    }
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+void CHECKPOINT_put_oscillator(CHECKPOINT_BUFFER *buffer, const RECURSIVE_OSCILLATOR *oscillator) {
+    CHECKPOINT_put_double(buffer, oscillator->frequency);
+    CHECKPOINT_put_double(buffer, oscillator->phase_offset);
+    CHECKPOINT_put_double(buffer, oscillator->sample_period);
+    CHECKPOINT_put_double(buffer, oscillator->last_time);
+    CHECKPOINT_put_double(buffer, oscillator->step_cos);
+    CHECKPOINT_put_double(buffer, oscillator->step_sin);
+    CHECKPOINT_put_double(buffer, oscillator->in_phase);
+    CHECKPOINT_put_double(buffer, oscillator->quadrature);
+    CHECKPOINT_put_int(buffer, oscillator->until_renormalize);
+    CHECKPOINT_put_int(buffer, oscillator->until_anchor);
+}
+
+void CHECKPOINT_get_oscillator(CHECKPOINT_BUFFER *buffer, RECURSIVE_OSCILLATOR *oscillator) {
+    oscillator->frequency = CHECKPOINT_get_double(buffer);
+    oscillator->phase_offset = CHECKPOINT_get_double(buffer);
+    oscillator->sample_period = CHECKPOINT_get_double(buffer);
+    oscillator->last_time = CHECKPOINT_get_double(buffer);
+    oscillator->step_cos = CHECKPOINT_get_double(buffer);
+    oscillator->step_sin = CHECKPOINT_get_double(buffer);
+    oscillator->in_phase = CHECKPOINT_get_double(buffer);
+    oscillator->quadrature = CHECKPOINT_get_double(buffer);
+    oscillator->until_renormalize = (int)CHECKPOINT_get_int(buffer);
+    oscillator->until_anchor = (int)CHECKPOINT_get_int(buffer);
+}
+
+void CHECKPOINT_put_error_metrics(CHECKPOINT_BUFFER *buffer, const ERROR_METRICS *metrics) {
+    const double sums[] = {metrics->ss, metrics->sc, metrics->s1, metrics->cc, metrics->c1, metrics->ys, metrics->yc,
+                           metrics->y1, metrics->time_sum};
+    CHECKPOINT_put_double(buffer, metrics->amplitude);
+    CHECKPOINT_put_int(buffer, metrics->window);
+    CHECKPOINT_put_int(buffer, metrics->count);
+    CHECKPOINT_put_double(buffer, metrics->sum_squares);
+    CHECKPOINT_put_double(buffer, metrics->peak);
+    CHECKPOINT_put_int(buffer, metrics->filled);
+    for (size_t i = 0; i < sizeof(sums) / sizeof(sums[0]); i++) {
+        CHECKPOINT_put_double(buffer, sums[i]);
+    }
+    CHECKPOINT_put_int(buffer, metrics->windows);
+    CHECKPOINT_put_double(buffer, metrics->fit_amplitude);
+    CHECKPOINT_put_double(buffer, metrics->fit_offset);
+    CHECKPOINT_put_double(buffer, metrics->fit_phase);
+    CHECKPOINT_put_double(buffer, metrics->first_time);
+    CHECKPOINT_put_double(buffer, metrics->sum_t);
+    CHECKPOINT_put_double(buffer, metrics->sum_tt);
+    CHECKPOINT_put_double(buffer, metrics->sum_p);
+    CHECKPOINT_put_double(buffer, metrics->sum_tp);
+}
+
+void CHECKPOINT_get_error_metrics(CHECKPOINT_BUFFER *buffer, ERROR_METRICS *metrics) {
+    double *sums[] = {&metrics->ss, &metrics->sc, &metrics->s1, &metrics->cc, &metrics->c1, &metrics->ys,
+                      &metrics->yc, &metrics->y1, &metrics->time_sum};
+    metrics->amplitude = CHECKPOINT_get_double(buffer);
+    metrics->window = (int)CHECKPOINT_get_int(buffer);
+    metrics->count = CHECKPOINT_get_int(buffer);
+    metrics->sum_squares = CHECKPOINT_get_double(buffer);
+    metrics->peak = CHECKPOINT_get_double(buffer);
+    metrics->filled = (int)CHECKPOINT_get_int(buffer);
+    for (size_t i = 0; i < sizeof(sums) / sizeof(sums[0]); i++) {
+        *sums[i] = CHECKPOINT_get_double(buffer);
+    }
+    metrics->windows = CHECKPOINT_get_int(buffer);
+    metrics->fit_amplitude = CHECKPOINT_get_double(buffer);
+    metrics->fit_offset = CHECKPOINT_get_double(buffer);
+    metrics->fit_phase = CHECKPOINT_get_double(buffer);
+    metrics->first_time = CHECKPOINT_get_double(buffer);
+    metrics->sum_t = CHECKPOINT_get_double(buffer);
+    metrics->sum_tt = CHECKPOINT_get_double(buffer);
+    metrics->sum_p = CHECKPOINT_get_double(buffer);
+    metrics->sum_tp = CHECKPOINT_get_double(buffer);
+}
+
+void CHECKPOINT_put_phase_truncation(CHECKPOINT_BUFFER *buffer, const PHASE_TRUNCATION *stage) {
+    CHECKPOINT_put_u64(buffer, stage->counter);
+    CHECKPOINT_put_u64(buffer, stage->error[0]);
+    CHECKPOINT_put_u64(buffer, stage->error[1]);
+}
+
+// stage must already be initialized with the same mode, bit depths and seed
+void CHECKPOINT_get_phase_truncation(CHECKPOINT_BUFFER *buffer, PHASE_TRUNCATION *stage) {
+    stage->counter = CHECKPOINT_get_u64(buffer);
+    stage->error[0] = CHECKPOINT_get_u64(buffer) & stage->low_mask;
+    stage->error[1] = CHECKPOINT_get_u64(buffer) & stage->low_mask;
+}
+
+// ASYNCHRONOUS WRITER --------------------------------------------------------------------------------------------------
+// write to a temporary file first so that an interrupted write never destroys the previous checkpoint
+static int write_file(const char *filename, const CHECKPOINT_BUFFER *buffer) {
+    char temporary[sizeof(((CHECKPOINT_WRITER *)0)->filename) + 4];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", filename);
+
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    size_t written = fwrite(buffer->data, 1, buffer->size, file);
+    int flushed = fflush(file) == 0;
+    fclose(file);
+    if (written != buffer->size || !flushed) {
+        remove(temporary);
+        return 0;
+    }
+
+#ifdef _WIN32
+    remove(filename);  // rename does not replace an existing file on Windows
+#endif
+    return rename(temporary, filename) == 0;
+}
+
+// write a buffer finished by CHECKPOINT_end through a temporary file, like the writer thread does, returns 1 on success
+int CHECKPOINT_save(const CHECKPOINT_BUFFER *buffer, const char *filename) {
+    return !buffer->error && strlen(filename) < sizeof(((CHECKPOINT_WRITER *)0)->filename)
+           && write_file(filename, buffer);
+}
+
+static void *writer_thread(void *argument) {
+    CHECKPOINT_WRITER *writer = (CHECKPOINT_WRITER *)argument;
+
+    pthread_mutex_lock(&writer->mutex);
+    while (1) {
+        while (writer->pending.size == 0 && !writer->stop) {
+            pthread_cond_wait(&writer->condition, &writer->mutex);
+        }
+        if (writer->pending.size == 0 && writer->stop) {
+            break;
+        }
+
+        // take the pending checkpoint and release the lock while writing
+        CHECKPOINT_BUFFER swap = writer->writing;
+        writer->writing = writer->pending;
+        writer->pending = swap;
+        CHECKPOINT_BUFFER_reset(&writer->pending);
+        pthread_mutex_unlock(&writer->mutex);
+
+        int ok = write_file(writer->filename, &writer->writing);
+
+        pthread_mutex_lock(&writer->mutex);
+        if (ok) {
+            writer->written++;
+        } else {
+            writer->failed++;  // reported by the caller from the counters
+        }
+    }
+    pthread_mutex_unlock(&writer->mutex);
+
+    return NULL;
+}
+
+int CHECKPOINT_WRITER_init(CHECKPOINT_WRITER *writer, const char *filename) {
+    snprintf(writer->filename, sizeof(writer->filename), "%s", filename);
+    CHECKPOINT_BUFFER_init(&writer->pending);
+    CHECKPOINT_BUFFER_init(&writer->writing);
+    writer->stop = 0;
+    writer->written = 0;
+    writer->replaced = 0;
+    writer->failed = 0;
+
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->condition, NULL);
+    writer->running = pthread_create(&writer->thread, NULL, writer_thread, writer) == 0;
+    return writer->running;
+}
+
+// hand a finished checkpoint to the writer, buffer receives an empty buffer to serialize the next checkpoint into
+void CHECKPOINT_WRITER_submit(CHECKPOINT_WRITER *writer, CHECKPOINT_BUFFER *buffer) {
+    if (buffer->error || buffer->size == 0) return;
+
+    if (!writer->running) {  // no thread, write synchronously
+        if (!write_file(writer->filename, buffer)) {
+            writer->failed++;
+        } else {
+            writer->written++;
+        }
+        CHECKPOINT_BUFFER_reset(buffer);
+        return;
+    }
+
+    pthread_mutex_lock(&writer->mutex);
+    if (writer->pending.size > 0) {
+        writer->replaced++;
+    }
+    CHECKPOINT_BUFFER swap = writer->pending;
+    writer->pending = *buffer;
+    *buffer = swap;
+    CHECKPOINT_BUFFER_reset(buffer);
+    pthread_cond_signal(&writer->condition);
+    pthread_mutex_unlock(&writer->mutex);
+}
+
+// waits for the last submitted checkpoint to be written
+void CHECKPOINT_WRITER_cleanup(CHECKPOINT_WRITER *writer) {
+    if (writer->running) {
+        pthread_mutex_lock(&writer->mutex);
+        writer->stop = 1;
+        pthread_cond_signal(&writer->condition);
+        pthread_mutex_unlock(&writer->mutex);
+        pthread_join(writer->thread, NULL);
+        writer->running = 0;
+    }
+    pthread_mutex_destroy(&writer->mutex);
+    pthread_cond_destroy(&writer->condition);
+    CHECKPOINT_BUFFER_cleanup(&writer->pending);
+    CHECKPOINT_BUFFER_cleanup(&writer->writing);
+}
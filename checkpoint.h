@@ -0,0 +1,106 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "nco.h"
+#include "comparator.h"
+#include "envelope.h"
+#include "fixed_point.h"
+#include "activity.h"
+#include "multirate.h"
+#include "accuracy.h"
+#include "dither.h"
+
+#define CHECKPOINT_MAGIC "DDSCKPT"  // 8 bytes including terminator
+#define CHECKPOINT_VERSION 1
+
+// CHECKPOINT BUFFER ----------------------------------------------------------------------------------------------------
+// growable byte buffer holding one serialized checkpoint, integers and doubles are stored little-endian
+typedef struct {
+    unsigned char *data;
+    size_t size;      // bytes written
+    size_t capacity;  // bytes allocated
+    size_t position;  // read cursor
+    int error;        // set on allocation failure or read past the end
+} CHECKPOINT_BUFFER;
+
+void CHECKPOINT_BUFFER_init(CHECKPOINT_BUFFER *buffer);
+void CHECKPOINT_BUFFER_reset(CHECKPOINT_BUFFER *buffer);
+void CHECKPOINT_BUFFER_cleanup(CHECKPOINT_BUFFER *buffer);
+
+void CHECKPOINT_put_bytes(CHECKPOINT_BUFFER *buffer, const void *bytes, size_t size);
+void CHECKPOINT_put_u64(CHECKPOINT_BUFFER *buffer, uint64_t value);
+void CHECKPOINT_put_int(CHECKPOINT_BUFFER *buffer, long long value);
+void CHECKPOINT_put_double(CHECKPOINT_BUFFER *buffer, double value);
+void CHECKPOINT_put_string(CHECKPOINT_BUFFER *buffer, const char *string);
+
+void CHECKPOINT_get_bytes(CHECKPOINT_BUFFER *buffer, void *bytes, size_t size);
+uint64_t CHECKPOINT_get_u64(CHECKPOINT_BUFFER *buffer);
+long long CHECKPOINT_get_int(CHECKPOINT_BUFFER *buffer);
+double CHECKPOINT_get_double(CHECKPOINT_BUFFER *buffer);
+void CHECKPOINT_get_string(CHECKPOINT_BUFFER *buffer, char *string, size_t size);
+
+// header (magic and version) and trailer (checksum of everything before it)
+void CHECKPOINT_begin(CHECKPOINT_BUFFER *buffer);
+void CHECKPOINT_end(CHECKPOINT_BUFFER *buffer);
+int CHECKPOINT_load(CHECKPOINT_BUFFER *buffer, const char *filename, const char **error);
+int CHECKPOINT_load_journal(CHECKPOINT_BUFFER *buffer, const char *filename, int64_t size, const char **error);
+int CHECKPOINT_save(const CHECKPOINT_BUFFER *buffer, const char *filename);
+
+// SIMULATION STATE -----------------------------------------------------------------------------------------------------
+// the get functions that can fail return 0 and point error, unless it is NULL, at the reason
+void CHECKPOINT_put_nco(CHECKPOINT_BUFFER *buffer, const NUMERICALLY_CONTROLLED_OSCILLATOR *nco);
+int CHECKPOINT_get_nco(CHECKPOINT_BUFFER *buffer, NUMERICALLY_CONTROLLED_OSCILLATOR *nco, const char **error);
+void CHECKPOINT_put_comparator(CHECKPOINT_BUFFER *buffer, const COMPARATOR *comparator);
+void CHECKPOINT_get_comparator(CHECKPOINT_BUFFER *buffer, COMPARATOR *comparator);
+void CHECKPOINT_put_envelope(CHECKPOINT_BUFFER *buffer, const ENVELOPE_PYRAMID *pyramid);
+int CHECKPOINT_get_envelope(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramid, const char **error);
+
+// completed envelope buckets never change, so instead of being stored in every checkpoint they are appended once to a
+// journal kept next to it, and a checkpoint only holds their number
+void CHECKPOINT_put_envelope_journal(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramid, int id);
+int CHECKPOINT_get_envelope_journal(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramids, int num_pyramids,
+                                    const char **error);
+
+// the whole pyramid with its completed buckets, for a pyramid file that outlives the run
+void CHECKPOINT_put_pyramid(CHECKPOINT_BUFFER *buffer, const ENVELOPE_PYRAMID *pyramid);
+int CHECKPOINT_get_pyramid(CHECKPOINT_BUFFER *buffer, ENVELOPE_PYRAMID *pyramid, const char **error);
+void CHECKPOINT_put_fixed_lpf(CHECKPOINT_BUFFER *buffer, const FIXED_LPF *lpf, const FIXED_OVERFLOW_COUNTERS *counters);
+int CHECKPOINT_get_fixed_lpf(CHECKPOINT_BUFFER *buffer, FIXED_LPF *lpf, FIXED_OVERFLOW_COUNTERS *counters,
+                             const char **error);
+void CHECKPOINT_put_gate_activity(CHECKPOINT_BUFFER *buffer, const GATE_ACTIVITY *activity);
+int CHECKPOINT_get_gate_activity(CHECKPOINT_BUFFER *buffer, GATE_ACTIVITY *activity, const char **error);
+void CHECKPOINT_put_interpolator(CHECKPOINT_BUFFER *buffer, const HALFBAND_INTERPOLATOR *interpolator);
+int CHECKPOINT_get_interpolator(CHECKPOINT_BUFFER *buffer, HALFBAND_INTERPOLATOR *interpolator, const char **error);
+void CHECKPOINT_put_decimator(CHECKPOINT_BUFFER *buffer, const CIC_DECIMATOR *decimator);
+int CHECKPOINT_get_decimator(CHECKPOINT_BUFFER *buffer, CIC_DECIMATOR *decimator, const char **error);
+void CHECKPOINT_put_oscillator(CHECKPOINT_BUFFER *buffer, const RECURSIVE_OSCILLATOR *oscillator);
+void CHECKPOINT_get_oscillator(CHECKPOINT_BUFFER *buffer, RECURSIVE_OSCILLATOR *oscillator);
+void CHECKPOINT_put_error_metrics(CHECKPOINT_BUFFER *buffer, const ERROR_METRICS *metrics);
+void CHECKPOINT_get_error_metrics(CHECKPOINT_BUFFER *buffer, ERROR_METRICS *metrics);
+void CHECKPOINT_put_phase_truncation(CHECKPOINT_BUFFER *buffer, const PHASE_TRUNCATION *stage);
+void CHECKPOINT_get_phase_truncation(CHECKPOINT_BUFFER *buffer, PHASE_TRUNCATION *stage);
+
+// ASYNCHRONOUS WRITER --------------------------------------------------------------------------------------------------
+// background thread writing the latest submitted checkpoint to a temporary file and renaming it over the target,
+// submitting only swaps buffers so the simulation never waits for the disk, a newer checkpoint replaces an unwritten one
+typedef struct {
+    char filename[1024];
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    CHECKPOINT_BUFFER pending;  // latest submitted checkpoint, empty when nothing is waiting
+    CHECKPOINT_BUFFER writing;  // checkpoint owned by the writer thread
+    int running;
+    int stop;
+    long long written;          // number of checkpoints written
+    long long replaced;         // number of checkpoints replaced by a newer one before being written
+    long long failed;           // number of checkpoints that could not be written
+} CHECKPOINT_WRITER;
+
+int CHECKPOINT_WRITER_init(CHECKPOINT_WRITER *writer, const char *filename);
+void CHECKPOINT_WRITER_submit(CHECKPOINT_WRITER *writer, CHECKPOINT_BUFFER *buffer);
+void CHECKPOINT_WRITER_cleanup(CHECKPOINT_WRITER *writer);
+
+#endif // CHECKPOINT_H
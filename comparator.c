@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <math.h>
+#include "comparator.h"
+
+// COMPARATOR -----------------------------------------------------------------------------------------------------------
+void COMPARATOR_init(COMPARATOR* comparator, double threshold, double hysteresis) {
+    comparator->threshold = threshold;
+    comparator->hysteresis = hysteresis < 0 ? 0 : hysteresis;
+    comparator->state = 0;
+    comparator->initialized = 0;
+    comparator->last_time = 0.0;
+    comparator->last_input = 0.0;
+
+    comparator->sample_count = 0;
+    comparator->high_count = 0;
+    comparator->crossing_count = 0;
+
+    comparator->rising_edge_seen = 0;
+    comparator->last_rising_time = 0.0;
+    comparator->period_count = 0;
+    comparator->period_mean = 0.0;
+    comparator->period_m2 = 0.0;
+    comparator->period_min = INFINITY;
+    comparator->period_max = 0.0;
+}
+
+// time at which the straight line between previous and current sample crosses the switching level
+static double crossing_time(const COMPARATOR* comparator, double time, double input, double level) {
+    double delta = input - comparator->last_input;
+    if (delta == 0.0) {
+        return time;
+    }
+    return comparator->last_time + (level - comparator->last_input) / delta * (time - comparator->last_time);
+}
+
+// output switches high above threshold + hysteresis/2 and low below threshold - hysteresis/2,
+// the period between two consecutive rising edges is folded into the running statistics
+int COMPARATOR_logic(COMPARATOR* comparator, double time, double input) {
+    double upper_level = comparator->threshold + comparator->hysteresis / 2;
+    double lower_level = comparator->threshold - comparator->hysteresis / 2;
+
+    if (!comparator->initialized) {
+        comparator->state = input > comparator->threshold ? 1 : 0;  // no edge on the first sample
+        comparator->initialized = 1;
+    } else if (!comparator->state && input > upper_level) {
+        comparator->state = 1;
+        comparator->crossing_count++;
+
+        double rising_time = crossing_time(comparator, time, input, upper_level);
+        if (comparator->rising_edge_seen) {
+            double period = rising_time - comparator->last_rising_time;
+            comparator->period_count++;
+            double delta = period - comparator->period_mean;
+            comparator->period_mean += delta / comparator->period_count;
+            comparator->period_m2 += delta * (period - comparator->period_mean);
+            if (period < comparator->period_min) comparator->period_min = period;
+            if (period > comparator->period_max) comparator->period_max = period;
+        }
+        comparator->last_rising_time = rising_time;
+        comparator->rising_edge_seen = 1;
+    } else if (comparator->state && input < lower_level) {
+        comparator->state = 0;
+        comparator->crossing_count++;
+    }
+
+    comparator->sample_count++;
+    comparator->high_count += comparator->state;
+    comparator->last_time = time;
+    comparator->last_input = input;
+
+    return comparator->state;
+}
+
+void COMPARATOR_get_statistics(const COMPARATOR* comparator, COMPARATOR_STATISTICS* statistics) {
+    statistics->duty_cycle = comparator->sample_count > 0
+        ? (double)comparator->high_count / (double)comparator->sample_count * 100 : 0.0;
+    statistics->crossing_count = comparator->crossing_count;
+    statistics->period_count = comparator->period_count;
+    statistics->frequency = comparator->period_count > 0 ? 1.0 / comparator->period_mean : 0.0;
+    statistics->jitter_rms = comparator->period_count > 1
+        ? sqrt(comparator->period_m2 / (comparator->period_count - 1)) : 0.0;
+    statistics->jitter_pp = comparator->period_count > 0 ? comparator->period_max - comparator->period_min : 0.0;
+}
@@ -0,0 +1,40 @@
+#ifndef COMPARATOR_H
+#define COMPARATOR_H
+
+// COMPARATOR -----------------------------------------------------------------------------------------------------------
+// comparator with hysteresis turning DAC output into a square wave, statistics are updated online in constant memory
+typedef struct {
+    double threshold;        // switching level, V
+    double hysteresis;       // width of hysteresis band centered on threshold, V
+    int state;               // comparator output, logic level
+    int initialized;         // whether the first sample has been seen
+    double last_time;        // time of previous sample, s
+    double last_input;       // previous input sample, V
+
+    long long sample_count;  // number of samples seen
+    long long high_count;    // number of samples at high level
+    long long crossing_count;// number of output transitions (rising and falling)
+
+    int rising_edge_seen;    // whether a rising edge has been seen
+    double last_rising_time; // interpolated time of previous rising edge, s
+    long long period_count;  // number of complete rising-edge-to-rising-edge periods
+    double period_mean;      // running mean of period, s (Welford)
+    double period_m2;        // running sum of squared deviations from mean, s^2 (Welford)
+    double period_min;       // shortest period, s
+    double period_max;       // longest period, s
+} COMPARATOR;
+
+typedef struct {
+    double duty_cycle;       // percentage of samples at high level, %
+    long long crossing_count;// number of zero crossings (output transitions)
+    long long period_count;  // number of measured periods
+    double frequency;        // frequency estimated from mean period, Hz
+    double jitter_rms;       // standard deviation of period, s
+    double jitter_pp;        // peak-to-peak period deviation, s
+} COMPARATOR_STATISTICS;
+
+void COMPARATOR_init(COMPARATOR* comparator, double threshold, double hysteresis);
+int COMPARATOR_logic(COMPARATOR* comparator, double time, double input);
+void COMPARATOR_get_statistics(const COMPARATOR* comparator, COMPARATOR_STATISTICS* statistics);
+
+#endif // COMPARATOR_H
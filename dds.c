@@ -0,0 +1,862 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "dds.h"
+#include "nco.h"
+
+#define ROM_TABLE_MAX_BITS 16     // larger ROMs are evaluated per sample instead of tabulated
+
+typedef struct {
+    double last_remainder;
+} ROLLOVER;
+
+// Direct form I low-pass filter, history holds the newest sample first
+typedef struct {
+    int order;
+    const double *b;
+    const double *a;
+    double x_history[DDS_MAX_FILTER_ORDER + 1];
+    double y_history[DDS_MAX_FILTER_ORDER + 1];
+} LPF;
+
+struct DDS_CONTEXT {
+    DDS_CONFIG config;
+    double T_sampling;            // sampling period, s
+    double time;                  // simulation time of the next tick, s
+    long long sample_count;       // number of samples produced
+
+    ROLLOVER rollover;            // synchronizes sampling and clock frequencies
+    NUMERICALLY_CONTROLLED_OSCILLATOR nco;
+    WORD_NCO word_nco;            // phase accumulator of the word level engine
+    double *rom_table;            // 2^dac_bit_depth ROM samples, NULL if evaluated per sample
+    PHASE_TRUNCATION truncation;  // dither or noise shaping of the ROM address
+    const KERNEL *kernel;         // specialized NCO, ROM, DAC and filter stages, NULL runs the generic ones
+    KERNEL_STATE kernel_state;
+    LPF lpf;
+    FIXED_LPF fixed_lpf;
+    FIXED_OVERFLOW_COUNTERS overflow_counters;
+    COMPARATOR comparator;
+    bool envelopes_enabled;
+    ENVELOPE_PYRAMID envelopes[DDS_NUM_SIGNALS];
+    GATE_ACTIVITY gate_activity;
+    RECURSIVE_OSCILLATOR reference;  // ideal sine wave
+    ERROR_METRICS error_metrics[DDS_NUM_OUTPUTS];
+    CIC_DECIMATOR analysis_decimators[DDS_NUM_OUTPUTS];  // DAC and filtered output at the analysis rate
+
+    // one block of samples on its way through the stages
+    double time_block[DDS_BLOCK_SIZE];
+    long long phase_block[DDS_BLOCK_SIZE];
+    long long address_block[DDS_BLOCK_SIZE];    // ROM address after the phase truncation stage
+    double dac_value_block[DDS_BLOCK_SIZE];
+    double rom_value_block[DDS_BLOCK_SIZE];
+    int16_t rom_word_block[DDS_BLOCK_SIZE];
+    int16_t dac_word_block[DDS_BLOCK_SIZE];
+    int32_t filter_word_block[DDS_BLOCK_SIZE];
+    double dac_output_block[DDS_BLOCK_SIZE];
+    double filtered_output_block[DDS_BLOCK_SIZE];
+    double in_phase_block[DDS_BLOCK_SIZE];      // cos and sin of the reference phase
+    double quadrature_block[DDS_BLOCK_SIZE];
+    int square_wave_block[DDS_BLOCK_SIZE];
+
+    // the same block after the analysis decimators, each output with the time and phase of the input completing it
+    double analysis_time_block[DDS_BLOCK_SIZE];
+    long long analysis_phase_block[DDS_BLOCK_SIZE];
+    double analysis_output_blocks[DDS_NUM_OUTPUTS][DDS_BLOCK_SIZE];
+    int analysis_square_wave_block[DDS_BLOCK_SIZE];
+};
+
+// error receives message unless it is NULL, returns 0 for the caller to pass on
+static int get_failed(const char **error, const char *message) {
+    if (error != NULL) {
+        *error = message;
+    }
+    return 0;
+}
+
+// CONFIGURATION --------------------------------------------------------------------------------------------------------
+void DDS_CONFIG_default(DDS_CONFIG *config) {
+    memset(config, 0, sizeof(DDS_CONFIG));
+    config->f_sampling = 120e6;
+    config->f_output = 5e2;
+    config->f_MCLK = 60e6;
+    config->N = 28;
+    config->dac_bit_depth = 10;
+    config->amplitude = 10 * 1e-3 * 100; // full scale current multiplied by shunt resistor resistance
+    config->phase_offset = 0;
+    config->t_end = 0;
+
+    config->filter_order = 4;
+    config->b[0] = 1.0;                  // pass-through until coefficients are read
+    config->a[0] = 1.0;
+
+    config->comparator_threshold = 0.0;
+    config->comparator_hysteresis = 0.0;
+
+    config->envelope_base_size = 16;
+    config->envelope_factor = 4;
+    config->envelope_reserve = 0;
+
+    config->fixed_point = false;
+    // the ROM peaks at 2^dac_bit_depth / (2^dac_bit_depth - 1), just above 1, which needs an integer bit, the DAC word
+    // is derived from the final dac_bit_depth by DDS_create
+    config->fixed_point_config.rom = (Q_FORMAT){1, 14};
+    config->fixed_point_config.coefficient = (Q_FORMAT){3, 28};
+    config->fixed_point_config.accumulator = (Q_FORMAT){3, 28};
+    config->fixed_point_config.dac = DDS_DAC_FORMAT_UNSET;
+    config->fixed_point_config.rounding = FIXED_ROUND_NEAREST;
+    config->fixed_point_config.overflow = FIXED_OVERFLOW_SATURATE;
+
+    config->gate_activity = false;
+    config->engine = DDS_ENGINE_GATE;
+    config->phase_truncation = PHASE_TRUNCATE;
+    config->dither_seed = 0;
+    config->specialized_kernels = true;
+
+    config->error_metrics = false;
+    config->fit_window = 0;
+
+    config->analysis_decimation = 0;
+    config->analysis_cic_order = 4;
+    config->analysis_compensation_taps = 31;
+}
+
+// Read the coefficients of numerator and denominator of discrete transfer function, returns 1 on success, error
+// receives the reason of a failure unless it is NULL
+int DDS_read_coefficients(DDS_CONFIG *config, const char *filename, const char **error) {
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL) {
+        return get_failed(error, "Unable to open the coefficients file");
+    }
+
+    int read = fscanf(file, "coefficients:\n") == 0;
+
+    // numerator coefficients
+    for (int i = 0; i <= config->filter_order; i++) {
+        read &= fscanf(file, "%lf", &config->b[i]) == 1;
+    }
+
+    // denominator coefficients
+    for (int i = 0; i <= config->filter_order; i++) {
+        read &= fscanf(file, "%lf", &config->a[i]) == 1;
+    }
+
+    fclose(file);
+
+    if (!read) {
+        return get_failed(error, "Coefficients file does not hold filter_order + 1 coefficients per polynomial");
+    }
+    return 1;
+}
+
+// STAGES ---------------------------------------------------------------------------------------------------------------
+static void init_ROLLOVER(ROLLOVER *rollover) {
+    rollover->last_remainder = 0;
+}
+
+// True if rollover using modulo operation
+static void check_rollover(ROLLOVER *rollover, double a, double n, bool *result) {
+
+    double this_remainder = fmod(a, n);
+    *result = this_remainder <= rollover->last_remainder;
+    rollover->last_remainder = this_remainder;
+}
+
+static void init_LPF(LPF *lpf, int order, const double *b, const double *a) {
+    lpf->order = order;
+    lpf->b = b;
+    lpf->a = a;
+    for (int i = 0; i <= DDS_MAX_FILTER_ORDER; i++) {
+        lpf->x_history[i] = 0.0;
+        lpf->y_history[i] = 0.0;
+    }
+}
+
+// y[k] = (b[0]*x[k] + ... + b[m]*x[k-m] - a[1]*y[k-1] - ... - a[n]*y[k-n]) / a[0]
+static double LPF_filter(LPF *lpf, double x) {
+    for (int i = lpf->order; i > 0; i--) {
+        lpf->x_history[i] = lpf->x_history[i - 1];
+        lpf->y_history[i] = lpf->y_history[i - 1];
+    }
+    lpf->x_history[0] = x;
+
+    double y = 0.0;
+    for (int i = 0; i <= lpf->order; i++) {
+        y += lpf->b[i] * lpf->x_history[i];
+    }
+    for (int i = 1; i <= lpf->order; i++) {
+        y -= lpf->a[i] * lpf->y_history[i];
+    }
+    y /= lpf->a[0];
+
+    lpf->y_history[0] = y;
+    return y;
+}
+
+// gain and phase shift of the filter for a sine wave of frequency f at sampling rate f_s, H(z) at z = exp(j*2*pi*f/f_s)
+static void LPF_response(const LPF *lpf, double f, double f_s, double *gain, double *phase_shift) {
+    double complex numerator = 0.0, denominator = 0.0;
+    for (int i = 0; i <= lpf->order; i++) {
+        double complex z_i = cexp(-I * 2 * M_PI * f / f_s * i);
+        numerator += lpf->b[i] * z_i;
+        denominator += lpf->a[i] * z_i;
+    }
+    *gain = cabs(numerator / denominator);
+    *phase_shift = carg(numerator / denominator);
+}
+
+// ROM sample at an N bit address whose bits below the dac_bit_depth most significant ones are zero
+static double sin_ROM_sample(int N, int address_int, int dac_bit_depth) {
+    return sin(2 * M_PI * address_int / (1 << N)) * (1 << dac_bit_depth);
+}
+
+// sin_ROM function implementation
+static void sin_ROM(int N, const char *address, int dac_bit_depth, char *dac_code, double *dac_value) {
+    strncpy(dac_code, address, dac_bit_depth);
+    dac_code[dac_bit_depth] = '\0';
+
+    char dac_code_makeupzero[N + 1];
+    strcpy(dac_code_makeupzero, dac_code);
+
+    for (int i = dac_bit_depth; i < N; i++) {
+        dac_code_makeupzero[i] = '0';
+    }
+    dac_code_makeupzero[N] = '\0';
+
+    int address_int = (int)strtol(dac_code_makeupzero, NULL, 2);
+    *dac_value = sin_ROM_sample(N, address_int, dac_bit_depth);
+}
+
+// word level ROM, the same samples as sin_ROM indexed by the truncated phase
+static void sin_ROM_block(const double *table, int N, int dac_bit_depth, const long long *phase, int count,
+                          double *dac_value) {
+    int shift = N - dac_bit_depth;
+    if (table != NULL) {
+        for (int k = 0; k < count; k++) {
+            dac_value[k] = table[phase[k] >> shift];
+        }
+    } else {
+        for (int k = 0; k < count; k++) {
+            dac_value[k] = sin_ROM_sample(N, (int)(phase[k] >> shift << shift), dac_bit_depth);
+        }
+    }
+}
+
+// DAC function implementation
+static double DAC(double A, double dac_value, int dac_bit_depth) {
+    return A * dac_value / (pow(2, dac_bit_depth) - 1);
+}
+
+// SYNTHESIZER ----------------------------------------------------------------------------------------------------------
+// frees a partly built context, error receives the reason unless it is NULL
+static DDS_CONTEXT *create_failed(DDS_CONTEXT *context, const char **error, const char *message) {
+    DDS_destroy(context);
+    get_failed(error, message);
+    return NULL;
+}
+
+// returns NULL if the configuration is not supported or memory is short, error receives the reason unless it is NULL
+DDS_CONTEXT *DDS_create(const DDS_CONFIG *config, const char **error) {
+    if (config->filter_order < 1 || config->filter_order > DDS_MAX_FILTER_ORDER || config->a[0] == 0.0
+        || config->N < 1 || config->N > 30 || config->dac_bit_depth < 1 || config->dac_bit_depth > config->N
+        || (config->engine != DDS_ENGINE_GATE && config->engine != DDS_ENGINE_WORD)) {
+        return create_failed(NULL, error, "Unsupported synthesizer configuration");
+    }
+    if (config->gate_activity && config->engine != DDS_ENGINE_GATE) {
+        return create_failed(NULL, error, "Gate activity is only counted by the gate level engine");
+    }
+
+    DDS_CONTEXT *context = (DDS_CONTEXT *)calloc(1, sizeof(DDS_CONTEXT));
+    if (context == NULL) {
+        return create_failed(NULL, error, "Memory allocation failed");
+    }
+
+    context->config = *config;
+    config = &context->config;
+    if (config->fixed_point_config.dac.fraction_bits < 0) {
+        // an integer bit for the sine peak, dac_bit_depth bits resolved over the full swing as far as the 16 bit lanes
+        // allow
+        int fraction_bits = config->dac_bit_depth - 1 < 14 ? config->dac_bit_depth - 1 : 14;
+        context->config.fixed_point_config.dac = (Q_FORMAT){1, fraction_bits};
+    }
+    context->T_sampling = 1.0 / config->f_sampling;
+    context->time = 0.0;
+    context->sample_count = 0;
+
+    init_ROLLOVER(&context->rollover);
+
+    NCO_init(&context->nco, config->N, (int)config->f_MCLK);
+    if (!NCO_set_output_frequency(&context->nco, config->f_output)) {
+        return create_failed(context, error, "NCO initialization failed");
+    }
+
+    // the gate level NCO keeps the registers as they were loaded, the word level engine clocks its own copy
+    WORD_NCO_init(&context->word_nco, config->N);
+    WORD_NCO_load(&context->word_nco, context->nco.phase_register, context->nco.delta_Phase);
+    if (!PHASE_TRUNCATION_init(&context->truncation, config->phase_truncation, config->N, config->dac_bit_depth,
+                               config->dither_seed)) {
+        return create_failed(context, error, "Unsupported phase truncation");
+    }
+    bool rom_addressed = config->engine == DDS_ENGINE_WORD || config->phase_truncation != PHASE_TRUNCATE;
+    if (rom_addressed && config->dac_bit_depth <= ROM_TABLE_MAX_BITS) {
+        int size = 1 << config->dac_bit_depth;
+        context->rom_table = (double *)malloc(size * sizeof(double));
+        if (context->rom_table == NULL) {
+            return create_failed(context, error, "Memory allocation failed");
+        }
+        for (int i = 0; i < size; i++) {
+            context->rom_table[i] = sin_ROM_sample(config->N, i << (config->N - config->dac_bit_depth),
+                                                   config->dac_bit_depth);
+        }
+    }
+
+    if (config->gate_activity) {
+        if (!GATE_ACTIVITY_init(&context->gate_activity, config->N)) {
+            return create_failed(context, error, "Unsupported gate activity width");
+        }
+        context->nco.n_bit_accumulator.activity = &context->gate_activity;
+    }
+
+    init_LPF(&context->lpf, config->filter_order, config->b, config->a);
+
+    // dispatch to a kernel compiled for this configuration, the generic stages cover everything else
+    if (config->specialized_kernels && config->engine == DDS_ENGINE_WORD && !config->fixed_point
+        && config->phase_truncation == PHASE_TRUNCATE && context->rom_table != NULL) {
+        context->kernel = KERNEL_select(config->N, config->dac_bit_depth, config->filter_order);
+        context->kernel_state = (KERNEL_STATE){&context->word_nco.phase_register, &context->word_nco.delta_Phase,
+                                               context->rom_table, config->amplitude, config->b, config->a,
+                                               context->lpf.x_history, context->lpf.y_history};
+    }
+    if (config->fixed_point && !FIXED_POINT_CONFIG_check(&config->fixed_point_config)) {
+        return create_failed(context, error, "ROM and DAC formats must be at most 16 bits wide, coefficient and "
+                                             "accumulator formats at most 32 bits");
+    }
+    if (config->fixed_point && !FIXED_LPF_init(&context->fixed_lpf, config->b, config->a, config->filter_order,
+                                               &config->fixed_point_config, &context->overflow_counters)) {
+        return create_failed(context, error, "Unable to factor the filter into second order sections");
+    }
+
+    COMPARATOR_init(&context->comparator, config->comparator_threshold, config->comparator_hysteresis);
+
+    // the analysis stages run at the decimated rate, the group delay of the decimators adds to the phase shift of the
+    // path, their gain at the output frequency is one within the compensated passband
+    double analysis_rate = config->f_MCLK, analysis_phase_shift = 0.0;
+    if (config->analysis_decimation > 0) {
+        for (int i = 0; i < DDS_NUM_OUTPUTS; i++) {
+            if (!CIC_DECIMATOR_init(&context->analysis_decimators[i], config->analysis_cic_order,
+                                    config->analysis_decimation, config->analysis_compensation_taps, 0.2,
+                                    2 * config->amplitude)) {
+                return create_failed(context, error, "Unsupported analysis decimator configuration");
+            }
+        }
+        analysis_rate = config->f_MCLK / config->analysis_decimation;
+        analysis_phase_shift = -2 * M_PI * config->f_output
+                               * CIC_DECIMATOR_delay(&context->analysis_decimators[DDS_OUTPUT_DAC]) / config->f_MCLK;
+    }
+
+    RECURSIVE_OSCILLATOR_init(&context->reference, config->f_output, config->phase_offset, analysis_rate);
+    int fit_window = config->fit_window > 0 ? config->fit_window : (int)round(analysis_rate / config->f_output);
+    double filter_gain, filter_phase_shift;  // the filtered output is compared with the filtered reference
+    LPF_response(&context->lpf, config->f_output, config->f_MCLK, &filter_gain, &filter_phase_shift);
+    ERROR_METRICS_init(&context->error_metrics[DDS_OUTPUT_DAC], config->amplitude, 1.0, analysis_phase_shift,
+                       fit_window);
+    ERROR_METRICS_init(&context->error_metrics[DDS_OUTPUT_FILTERED], config->amplitude, filter_gain,
+                       filter_phase_shift + analysis_phase_shift, fit_window);
+
+    context->envelopes_enabled = config->envelope_reserve > 0;
+    for (int i = 0; i < DDS_NUM_SIGNALS; i++) {
+        ENVELOPE_PYRAMID_init(&context->envelopes[i], config->envelope_base_size, config->envelope_factor);
+        if (context->envelopes_enabled && !ENVELOPE_PYRAMID_reserve(&context->envelopes[i], config->envelope_reserve)) {
+            return create_failed(context, error, "Memory allocation failed for envelope levels");
+        }
+    }
+
+    return context;
+}
+
+// step the clock until count NCO ticks are due or the run ends, time receives the time of each tick unless it is NULL,
+// returns the number of ticks
+static long long step_clock(DDS_CONTEXT *context, long long count, double *time) {
+    const DDS_CONFIG *config = &context->config;
+    long long produced = 0;
+    bool rollover_detected;
+
+    while (produced < count && (config->t_end <= 0 || context->time < config->t_end)) {
+
+        check_rollover(&context->rollover, context->time, (1.0 / config->f_MCLK), &rollover_detected);
+        if (rollover_detected) {  // If sampling frequency is synchronized with clock frequency
+            if (time != NULL) {
+                time[produced] = context->time;
+            }
+            produced++;
+        }
+
+        // Increment time
+        context->time += context->T_sampling;
+    }
+    return produced;
+}
+
+// step the clock until count NCO ticks have produced phase and ROM output, or the run ends
+static int generate_block(DDS_CONTEXT *context, int count) {
+    const DDS_CONFIG *config = &context->config;
+    int produced = (int)step_clock(context, count, context->time_block);
+
+    bool truncation_stage = config->phase_truncation != PHASE_TRUNCATE;
+    if (context->kernel != NULL) {
+        // all the way to the filter output, process_block continues after the filter
+        context->kernel->function(&context->kernel_state, produced, context->phase_block, context->dac_value_block,
+                                  context->dac_output_block, context->filtered_output_block);
+        return produced;
+    } else if (config->engine == DDS_ENGINE_WORD) {
+        WORD_NCO_phase_accumulator(&context->word_nco, produced, context->phase_block);
+    } else {
+        char dac_code[config->N + 1];
+        for (int k = 0; k < produced; k++) {
+            // Use the data output from phase accumulator as phase sampling address of waveform memory (ROM)
+            const char *phase_address = NCO_phase_accumulator(&context->nco);
+
+            // Get DAC code and value from sin_ROM
+            if (!truncation_stage) {
+                sin_ROM(config->N, phase_address, config->dac_bit_depth, dac_code, &context->dac_value_block[k]);
+            }
+            context->phase_block[k] = strtoll(phase_address, NULL, 2);
+        }
+    }
+
+    // dithered or noise shaped ROM address, plain truncation is part of the ROM lookup
+    if (truncation_stage) {
+        PHASE_TRUNCATION_process(&context->truncation, context->phase_block, produced, context->address_block);
+        sin_ROM_block(context->rom_table, config->N, config->dac_bit_depth, context->address_block, produced,
+                      context->dac_value_block);
+    } else if (config->engine == DDS_ENGINE_WORD) {
+        sin_ROM_block(context->rom_table, config->N, config->dac_bit_depth, context->phase_block, produced,
+                      context->dac_value_block);
+    }
+
+    return produced;
+}
+
+// DAC, filter and analysis stages, each over the whole block
+static void process_block(DDS_CONTEXT *context, int count) {
+    const DDS_CONFIG *config = &context->config;
+
+    if (context->kernel != NULL) {
+        // DAC and filter outputs are already there
+    } else if (config->fixed_point) {
+        // ROM word, DAC input word and filter output, quantized as in hardware, at the full scale of DAC()
+        const FIXED_POINT_CONFIG *fixed = &config->fixed_point_config;
+        const double full_scale = (double)((1 << config->dac_bit_depth) - 1);
+        for (int k = 0; k < count; k++) {
+            context->rom_value_block[k] = context->dac_value_block[k] / full_scale;
+        }
+        FIXED_quantize_block(context->rom_value_block, context->rom_word_block, count, fixed->rom, fixed->rounding,
+                             fixed->overflow, &context->overflow_counters.rom);
+        FIXED_requantize_block(context->rom_word_block, fixed->rom, context->dac_word_block, count, fixed->dac,
+                               fixed->rounding, fixed->overflow, &context->overflow_counters.dac);
+        FIXED_LPF_filter_block(&context->fixed_lpf, context->dac_word_block, context->filter_word_block, count,
+                               &context->overflow_counters);
+        for (int k = 0; k < count; k++) {
+            context->dac_output_block[k] = config->amplitude * FIXED_to_double(context->dac_word_block[k], fixed->dac);
+            context->filtered_output_block[k] = config->amplitude
+                                                * FIXED_to_double(context->filter_word_block[k], fixed->accumulator);
+        }
+    } else {
+        for (int k = 0; k < count; k++) {
+            context->dac_output_block[k] = DAC(config->amplitude, context->dac_value_block[k], config->dac_bit_depth);
+        }
+        for (int k = 0; k < count; k++) {
+            context->filtered_output_block[k] = LPF_filter(&context->lpf, context->dac_output_block[k]);
+        }
+    }
+
+    // the analysis stages see every sample, or the outputs of the analysis decimators
+    int analysed = count;
+    const double *time = context->time_block;
+    const long long *phase = context->phase_block;
+    const double *dac_output = context->dac_output_block;
+    const double *filtered_output = context->filtered_output_block;
+    int *square_wave = context->square_wave_block;
+    const int ratio = config->analysis_decimation;
+    int first = ratio > 0 ? ratio - 1 - context->analysis_decimators[DDS_OUTPUT_DAC].phase : 0;
+    if (ratio > 0) {
+        analysed = CIC_DECIMATOR_process(&context->analysis_decimators[DDS_OUTPUT_DAC], dac_output, count,
+                                         context->analysis_output_blocks[DDS_OUTPUT_DAC]);
+        CIC_DECIMATOR_process(&context->analysis_decimators[DDS_OUTPUT_FILTERED], filtered_output, count,
+                              context->analysis_output_blocks[DDS_OUTPUT_FILTERED]);
+        // outputs are left out until the CIC and the compensation filter have filled, their start-up transient would
+        // count as comparator crossings and output error
+        const CIC_DECIMATOR *decimator = &context->analysis_decimators[DDS_OUTPUT_DAC];
+        long long filled = (long long)(decimator->order + decimator->compensator.num_taps - 1) * ratio;
+        int skipped = 0;
+        while (skipped < analysed && context->sample_count + first + skipped * ratio < filled) {
+            skipped++;
+        }
+        analysed -= skipped;
+        for (int j = 0; j < analysed; j++) {
+            context->analysis_time_block[j] = time[first + (skipped + j) * ratio];
+            context->analysis_phase_block[j] = phase[first + (skipped + j) * ratio];
+        }
+        time = context->analysis_time_block;
+        phase = context->analysis_phase_block;
+        dac_output = context->analysis_output_blocks[DDS_OUTPUT_DAC] + skipped;
+        filtered_output = context->analysis_output_blocks[DDS_OUTPUT_FILTERED] + skipped;
+        square_wave = context->analysis_square_wave_block;
+        first += skipped * ratio;
+    }
+
+    // Reference sine wave, and how far the outputs are from it
+    RECURSIVE_OSCILLATOR_generate(&context->reference, time, analysed, context->in_phase_block,
+                                  context->quadrature_block);
+    if (config->error_metrics) {
+        ERROR_METRICS_update(&context->error_metrics[DDS_OUTPUT_DAC], time, context->in_phase_block,
+                             context->quadrature_block, dac_output, analysed);
+        ERROR_METRICS_update(&context->error_metrics[DDS_OUTPUT_FILTERED], time, context->in_phase_block,
+                             context->quadrature_block, filtered_output, analysed);
+    }
+
+    // Square wave calculation, comparator statistics are updated in the same pass
+    int held = context->comparator.state;
+    for (int k = 0; k < analysed; k++) {
+        square_wave[k] = COMPARATOR_logic(&context->comparator, time[k], dac_output[k]);
+    }
+    if (ratio > 0) {
+        // every sample keeps the decision of the last analysed one
+        for (int k = 0, j = 0; k < count; k++) {
+            if (j < analysed && k == first + j * ratio) {
+                held = square_wave[j++];
+            }
+            context->square_wave_block[k] = held;
+        }
+    }
+
+    if (context->envelopes_enabled) {
+        for (int k = 0; k < analysed; k++) {
+            ENVELOPE_PYRAMID_add(&context->envelopes[DDS_SIGNAL_PHASE], time[k], phase[k]);
+            ENVELOPE_PYRAMID_add(&context->envelopes[DDS_SIGNAL_DAC_OUTPUT], time[k], dac_output[k]);
+            ENVELOPE_PYRAMID_add(&context->envelopes[DDS_SIGNAL_SQUARE_WAVE], time[k], square_wave[k]);
+        }
+    }
+}
+
+static void copy_block(const DDS_CONTEXT *context, int count, const DDS_SAMPLES *samples, int offset) {
+    const DDS_CONFIG *config = &context->config;
+
+    if (samples->time != NULL) {
+        memcpy(samples->time + offset, context->time_block, count * sizeof(double));
+    }
+    if (samples->phase != NULL) {
+        memcpy(samples->phase + offset, context->phase_block, count * sizeof(long long));
+    }
+    if (samples->dac_output != NULL) {
+        memcpy(samples->dac_output + offset, context->dac_output_block, count * sizeof(double));
+    }
+    if (samples->filtered_output != NULL) {
+        memcpy(samples->filtered_output + offset, context->filtered_output_block, count * sizeof(double));
+    }
+    if (samples->square_wave != NULL) {
+        memcpy(samples->square_wave + offset, context->square_wave_block, count * sizeof(int));
+    }
+    if (samples->rom_output != NULL) {
+        memcpy(samples->rom_output + offset, context->dac_value_block, count * sizeof(double));
+    }
+    if (samples->sine_reference != NULL) {
+        for (int k = 0; k < count; k++) {
+            samples->sine_reference[offset + k] = config->amplitude * context->quadrature_block[k];
+        }
+    }
+}
+
+// produce the next n samples into the caller's buffers without allocating or doing I/O, returns the number of
+// samples produced, which is less than n only when the end of the run is reached
+int DDS_pull(DDS_CONTEXT *context, int n, const DDS_SAMPLES *samples) {
+    int produced = 0;
+    while (produced < n) {
+        int count = generate_block(context, n - produced < DDS_BLOCK_SIZE ? n - produced : DDS_BLOCK_SIZE);
+        if (count == 0) {
+            break;
+        }
+        process_block(context, count);
+        copy_block(context, count, samples, produced);
+        context->sample_count += count;
+        produced += count;
+    }
+    return produced;
+}
+
+// skip ahead so that the next sample pulled is sample sample_index of the run, returns the index of that sample, which
+// is less than sample_index only when the run ends before it. The clock is stepped to keep the sample times those of
+// an uninterrupted run, the phase accumulator and the phase truncation stage jump in constant time, so a long run can
+// be split into time chunks pulled by separate contexts, whose phase, ROM and DAC output match the run in one piece bit
+// for bit. The skipped samples reach none of the later stages: the filter and comparator of a fresh context start from
+// rest at the first sample pulled, and error metrics, envelopes and gate activity leave them out
+long long DDS_seek(DDS_CONTEXT *context, long long sample_index) {
+    long long n = step_clock(context, sample_index - context->sample_count, NULL);
+    if (n <= 0) {
+        return context->sample_count;
+    }
+
+    // the engine that is clocked holds the registers, see DDS_set_frequency_tuning_word
+    long long phase, frequency_tuning_word;
+    if (context->config.engine == DDS_ENGINE_GATE) {
+        phase = strtoll(NCO_get_phase_register(&context->nco), NULL, 2);
+        frequency_tuning_word = strtoll(NCO_get_frequency_tuning_word(&context->nco), NULL, 2);
+    } else {
+        phase = context->word_nco.phase_register;
+        frequency_tuning_word = context->word_nco.delta_Phase;
+    }
+    const uint64_t mask = context->word_nco.mask;
+    PHASE_TRUNCATION_advance(&context->truncation, n, (long long)(((uint64_t)phase + frequency_tuning_word) & mask),
+                             frequency_tuning_word);
+    DDS_set_phase_register(context, (long long)(((uint64_t)phase + (uint64_t)n * frequency_tuning_word) & mask));
+    context->sample_count += n;
+    return context->sample_count;
+}
+
+void DDS_destroy(DDS_CONTEXT *context) {
+    if (context == NULL) return;
+    NCO_cleanup(&context->nco);
+    free(context->rom_table);
+    for (int i = 0; i < DDS_NUM_SIGNALS; i++) {
+        ENVELOPE_PYRAMID_cleanup(&context->envelopes[i]);
+    }
+    free(context);
+}
+
+// binary string of the N least significant bits, MSB first
+static void register_string(int N, long long value, char *string) {
+    for (int i = 0; i < N; i++) {
+        string[N - 1 - i] = (value >> i) & 1 ? '1' : '0';
+    }
+    string[N] = '\0';
+}
+
+// both engines are kept loaded, only the selected one is clocked
+void DDS_set_frequency_tuning_word(DDS_CONTEXT *context, long long frequency_tuning_word) {
+    char string[context->config.N + 1];
+    register_string(context->config.N, frequency_tuning_word, string);
+    NCO_set_frequency_tuning_word(&context->nco, string);
+    context->word_nco.delta_Phase = (uint32_t)frequency_tuning_word & context->word_nco.mask;
+}
+
+void DDS_set_phase_register(DDS_CONTEXT *context, long long phase) {
+    char string[context->config.N + 1];
+    register_string(context->config.N, phase, string);
+    NCO_set_phase_register(&context->nco, string);
+    context->word_nco.phase_register = (uint32_t)phase & context->word_nco.mask;
+}
+
+const DDS_CONFIG *DDS_get_config(const DDS_CONTEXT *context) {
+    return &context->config;
+}
+
+double DDS_get_time(const DDS_CONTEXT *context) {
+    return context->time;
+}
+
+// binary string, MSB first
+const char *DDS_get_frequency_tuning_word(const DDS_CONTEXT *context) {
+    return NCO_get_frequency_tuning_word(&context->nco);
+}
+
+const char *DDS_engine_name(DDS_ENGINE engine) {
+    switch (engine) {
+        case DDS_ENGINE_GATE: return "gate";
+        case DDS_ENGINE_WORD: return "word";
+    }
+    return "unknown";
+}
+
+// name of the specialized kernel in use, "generic" if there is none
+const char *DDS_get_kernel_name(const DDS_CONTEXT *context) {
+    return context->kernel != NULL ? context->kernel->name : "generic";
+}
+
+long long DDS_get_sample_count(const DDS_CONTEXT *context) {
+    return context->sample_count;
+}
+
+void DDS_get_comparator_statistics(const DDS_CONTEXT *context, COMPARATOR_STATISTICS *statistics) {
+    COMPARATOR_get_statistics(&context->comparator, statistics);
+}
+
+void DDS_get_overflow_counters(const DDS_CONTEXT *context, FIXED_OVERFLOW_COUNTERS *counters) {
+    *counters = context->overflow_counters;
+}
+
+// NULL when envelopes are disabled
+const ENVELOPE_PYRAMID *DDS_get_envelope(const DDS_CONTEXT *context, DDS_SIGNAL signal) {
+    if (!context->envelopes_enabled || signal < 0 || signal >= DDS_NUM_SIGNALS) {
+        return NULL;
+    }
+    return &context->envelopes[signal];
+}
+
+// NULL when gate activity is not counted
+const GATE_ACTIVITY *DDS_get_gate_activity(const DDS_CONTEXT *context) {
+    return context->config.gate_activity ? &context->gate_activity : NULL;
+}
+
+// NULL when error metrics are disabled
+const ERROR_METRICS *DDS_get_error_metrics(const DDS_CONTEXT *context, DDS_OUTPUT output) {
+    if (!context->config.error_metrics || output < 0 || output >= DDS_NUM_OUTPUTS) {
+        return NULL;
+    }
+    return &context->error_metrics[output];
+}
+
+// CHECKPOINT -----------------------------------------------------------------------------------------------------------
+// the configuration is stored so that resuming with a different one is refused
+void DDS_put_checkpoint(const DDS_CONTEXT *context, CHECKPOINT_BUFFER *buffer) {
+    const DDS_CONFIG *config = &context->config;
+    CHECKPOINT_put_double(buffer, config->f_sampling);
+    CHECKPOINT_put_double(buffer, config->f_output);
+    CHECKPOINT_put_double(buffer, config->f_MCLK);
+    CHECKPOINT_put_int(buffer, config->N);
+    CHECKPOINT_put_int(buffer, config->dac_bit_depth);
+    CHECKPOINT_put_double(buffer, config->amplitude);
+    CHECKPOINT_put_int(buffer, config->filter_order);
+    for (int i = 0; i <= config->filter_order; i++) {
+        CHECKPOINT_put_double(buffer, config->b[i]);
+        CHECKPOINT_put_double(buffer, config->a[i]);
+    }
+    CHECKPOINT_put_int(buffer, config->fixed_point);
+    CHECKPOINT_put_int(buffer, context->envelopes_enabled);
+    CHECKPOINT_put_int(buffer, config->gate_activity);
+    CHECKPOINT_put_int(buffer, config->engine);
+    CHECKPOINT_put_int(buffer, config->phase_truncation);
+    CHECKPOINT_put_u64(buffer, config->dither_seed);
+    CHECKPOINT_put_int(buffer, config->error_metrics);
+    CHECKPOINT_put_int(buffer, context->error_metrics[0].window);
+    CHECKPOINT_put_int(buffer, config->analysis_decimation);
+
+    CHECKPOINT_put_double(buffer, context->time);
+    CHECKPOINT_put_int(buffer, context->sample_count);
+    CHECKPOINT_put_double(buffer, context->rollover.last_remainder);
+
+    for (int i = 0; i <= config->filter_order; i++) {
+        CHECKPOINT_put_double(buffer, context->lpf.x_history[i]);
+        CHECKPOINT_put_double(buffer, context->lpf.y_history[i]);
+    }
+    if (config->fixed_point) {
+        CHECKPOINT_put_fixed_lpf(buffer, &context->fixed_lpf, &context->overflow_counters);
+    }
+
+    CHECKPOINT_put_nco(buffer, &context->nco);
+    CHECKPOINT_put_int(buffer, context->word_nco.phase_register);
+    CHECKPOINT_put_int(buffer, context->word_nco.delta_Phase);
+    CHECKPOINT_put_phase_truncation(buffer, &context->truncation);
+    if (config->gate_activity) {
+        CHECKPOINT_put_gate_activity(buffer, &context->gate_activity);
+    }
+    CHECKPOINT_put_comparator(buffer, &context->comparator);
+    CHECKPOINT_put_oscillator(buffer, &context->reference);
+    if (config->analysis_decimation > 0) {
+        for (int i = 0; i < DDS_NUM_OUTPUTS; i++) {
+            CHECKPOINT_put_decimator(buffer, &context->analysis_decimators[i]);
+        }
+    }
+    if (config->error_metrics) {
+        for (int i = 0; i < DDS_NUM_OUTPUTS; i++) {
+            CHECKPOINT_put_error_metrics(buffer, &context->error_metrics[i]);
+        }
+    }
+    if (context->envelopes_enabled) {
+        for (int i = 0; i < DDS_NUM_SIGNALS; i++) {
+            CHECKPOINT_put_envelope(buffer, &context->envelopes[i]);
+        }
+    }
+}
+
+// context must have been created with the configuration the checkpoint was written with, returns 1 on success, error
+// receives the reason of a failure unless it is NULL
+int DDS_get_checkpoint(DDS_CONTEXT *context, CHECKPOINT_BUFFER *buffer, const char **error) {
+    const DDS_CONFIG *config = &context->config;
+    int same = CHECKPOINT_get_double(buffer) == config->f_sampling;
+    same &= CHECKPOINT_get_double(buffer) == config->f_output;
+    same &= CHECKPOINT_get_double(buffer) == config->f_MCLK;
+    same &= CHECKPOINT_get_int(buffer) == config->N;
+    same &= CHECKPOINT_get_int(buffer) == config->dac_bit_depth;
+    same &= CHECKPOINT_get_double(buffer) == config->amplitude;
+    same &= CHECKPOINT_get_int(buffer) == config->filter_order;
+    for (int i = 0; same && i <= config->filter_order; i++) {
+        same &= CHECKPOINT_get_double(buffer) == config->b[i];  // the filter history only fits its own coefficients
+        same &= CHECKPOINT_get_double(buffer) == config->a[i];
+    }
+    same &= CHECKPOINT_get_int(buffer) == config->fixed_point;
+    same &= CHECKPOINT_get_int(buffer) == context->envelopes_enabled;
+    same &= CHECKPOINT_get_int(buffer) == config->gate_activity;
+    same &= CHECKPOINT_get_int(buffer) == config->engine;
+    same &= CHECKPOINT_get_int(buffer) == config->phase_truncation;
+    same &= CHECKPOINT_get_u64(buffer) == config->dither_seed;
+    same &= CHECKPOINT_get_int(buffer) == config->error_metrics;
+    same &= CHECKPOINT_get_int(buffer) == context->error_metrics[0].window;
+    same &= CHECKPOINT_get_int(buffer) == config->analysis_decimation;
+    if (buffer->error || !same) {
+        return get_failed(error, "Checkpoint was written with a different configuration");
+    }
+
+    context->time = CHECKPOINT_get_double(buffer);
+    context->sample_count = CHECKPOINT_get_int(buffer);
+    context->rollover.last_remainder = CHECKPOINT_get_double(buffer);
+
+    for (int i = 0; i <= config->filter_order; i++) {
+        context->lpf.x_history[i] = CHECKPOINT_get_double(buffer);
+        context->lpf.y_history[i] = CHECKPOINT_get_double(buffer);
+    }
+    if (config->fixed_point
+        && !CHECKPOINT_get_fixed_lpf(buffer, &context->fixed_lpf, &context->overflow_counters, error)) {
+        return 0;
+    }
+
+    if (!CHECKPOINT_get_nco(buffer, &context->nco, error)) {
+        return 0;
+    }
+    context->word_nco.phase_register = (uint32_t)CHECKPOINT_get_int(buffer) & context->word_nco.mask;
+    context->word_nco.delta_Phase = (uint32_t)CHECKPOINT_get_int(buffer) & context->word_nco.mask;
+    CHECKPOINT_get_phase_truncation(buffer, &context->truncation);
+    if (config->gate_activity && !CHECKPOINT_get_gate_activity(buffer, &context->gate_activity, error)) {
+        return 0;
+    }
+    CHECKPOINT_get_comparator(buffer, &context->comparator);
+    CHECKPOINT_get_oscillator(buffer, &context->reference);
+    for (int i = 0; config->analysis_decimation > 0 && i < DDS_NUM_OUTPUTS; i++) {
+        if (!CHECKPOINT_get_decimator(buffer, &context->analysis_decimators[i], error)) {
+            return 0;
+        }
+    }
+    if (config->error_metrics) {
+        for (int i = 0; i < DDS_NUM_OUTPUTS; i++) {
+            CHECKPOINT_get_error_metrics(buffer, &context->error_metrics[i]);
+        }
+    }
+    if (context->envelopes_enabled) {
+        for (int i = 0; i < DDS_NUM_SIGNALS; i++) {
+            if (!CHECKPOINT_get_envelope(buffer, &context->envelopes[i], error)) {
+                return 0;
+            }
+            if (!ENVELOPE_PYRAMID_reserve(&context->envelopes[i], config->envelope_reserve)) {
+                return get_failed(error, "Memory allocation failed");
+            }
+        }
+    }
+
+    return buffer->error ? get_failed(error, "Checkpoint is truncated") : 1;
+}
+
+// records of the envelope buckets completed since the last call
+void DDS_put_envelope_journal(DDS_CONTEXT *context, CHECKPOINT_BUFFER *journal) {
+    if (context->envelopes_enabled) {
+        for (int i = 0; i < DDS_NUM_SIGNALS; i++) {
+            CHECKPOINT_put_envelope_journal(journal, &context->envelopes[i], i);
+        }
+    }
+}
+
+// returns 1 on success, error receives the reason of a failure unless it is NULL
+int DDS_get_envelope_journal(DDS_CONTEXT *context, CHECKPOINT_BUFFER *journal, const char **error) {
+    return !context->envelopes_enabled
+           || CHECKPOINT_get_envelope_journal(journal, context->envelopes, DDS_NUM_SIGNALS, error);
+}
@@ -0,0 +1,129 @@
+#ifndef DDS_H
+#define DDS_H
+#include <stdbool.h>
+#include "comparator.h"
+#include "envelope.h"
+#include "checkpoint.h"
+#include "fixed_point.h"
+#include "activity.h"
+#include "accuracy.h"
+#include "dither.h"
+#include "kernel.h"
+#include "multirate.h"
+
+#define DDS_MAX_FILTER_ORDER FIXED_LPF_MAX_ORDER
+#define DDS_BLOCK_SIZE FIXED_BLOCK_SIZE  // samples processed per stage before moving to the next stage
+#define DDS_DAC_FORMAT_UNSET ((Q_FORMAT){-1, -1})  // DAC word follows dac_bit_depth, see DDS_CONFIG
+
+// CONFIGURATION --------------------------------------------------------------------------------------------------------
+// implementation of the phase accumulator and ROM, both produce the same samples bit for bit
+typedef enum {
+    DDS_ENGINE_GATE,              // N one bit accumulators built from gates, the reference
+    DDS_ENGINE_WORD               // integer phase accumulator and a ROM table
+} DDS_ENGINE;
+
+typedef struct {
+    double f_sampling;            // sampling frequency, is twice system clock frequency
+    double f_output;              // output frequency, not exceeding 0.4 * f_MCLK
+    double f_MCLK;                // clock frequency
+    int N;                        // bit depth of phase accumulator
+    int dac_bit_depth;            // bit depth of DAC
+    double amplitude;             // amplitude of DAC output, V
+    double phase_offset;          // phase offset of reference sine wave, rad
+    double t_end;                 // end of the run, s, no samples are produced from then on, 0 runs forever
+
+    int filter_order;             // low-pass filter order
+    double b[DDS_MAX_FILTER_ORDER + 1]; // numerator coefficients of discrete transfer function
+    double a[DDS_MAX_FILTER_ORDER + 1]; // denominator coefficients of discrete transfer function
+
+    double comparator_threshold;  // switching level of square wave comparator, V
+    double comparator_hysteresis; // hysteresis band of square wave comparator, V
+
+    int envelope_base_size;       // samples per bucket at the finest envelope level
+    int envelope_factor;          // each envelope level is this many times coarser than the one below, 2 to 16
+    long long envelope_reserve;   // samples to reserve envelope memory for at creation, later ones are dropped and
+                                  // counted, 0 disables envelopes
+
+    bool fixed_point;             // run ROM, DAC and filter datapath in fixed point
+    FIXED_POINT_CONFIG fixed_point_config; // DAC word DDS_DAC_FORMAT_UNSET by default, DDS_create then uses
+                                           // Q1.(dac_bit_depth - 1) of the final dac_bit_depth, at most Q1.14
+
+    bool gate_activity;           // count toggles of every net of the phase accumulator
+    DDS_ENGINE engine;            // phase accumulator and ROM implementation
+    PHASE_TRUNCATION_MODE phase_truncation; // how the phase is reduced to dac_bit_depth bits before the ROM
+    uint64_t dither_seed;         // selects the dither sequence, runs with the same seed are identical
+    bool specialized_kernels;     // run a compiled kernel if one matches N, DAC bit depth and filter order, see kernel.h
+
+    bool error_metrics;           // compare DAC and filtered output with the reference sine wave
+    int fit_window;               // samples per least-squares sine fit, 0 for one period of the output frequency
+
+    int analysis_decimation;      // comparator, envelopes and error metrics see the DAC and filtered outputs decimated
+                                  // by this ratio with a compensated CIC, at f_MCLK / ratio, 0 analyses every sample
+    int analysis_cic_order;       // integrator and comb sections of the analysis decimator
+    int analysis_compensation_taps; // taps of its droop compensation filter
+} DDS_CONFIG;
+
+void DDS_CONFIG_default(DDS_CONFIG *config);
+int DDS_read_coefficients(DDS_CONFIG *config, const char *filename, const char **error);
+
+// SYNTHESIZER ----------------------------------------------------------------------------------------------------------
+// opaque context holding the NCO, ROM, DAC, filter and analysis stages of one synthesizer
+typedef struct DDS_CONTEXT DDS_CONTEXT;
+
+// caller supplied output buffers of at least n entries each, a NULL buffer is neither written nor computed
+typedef struct {
+    double *time;                 // sample time, s
+    long long *phase;             // phase register
+    double *dac_output;           // DAC output, V
+    double *filtered_output;      // low-pass filtered DAC output, V
+    double *sine_reference;       // ideal sine wave, V
+    int *square_wave;             // comparator output, logic level
+    double *rom_output;           // sine ROM output, full scale 2^dac_bit_depth
+} DDS_SAMPLES;
+
+typedef enum {
+    DDS_SIGNAL_PHASE,
+    DDS_SIGNAL_DAC_OUTPUT,
+    DDS_SIGNAL_SQUARE_WAVE,
+    DDS_NUM_SIGNALS
+} DDS_SIGNAL;
+
+// outputs compared with the reference sine wave
+typedef enum {
+    DDS_OUTPUT_DAC,
+    DDS_OUTPUT_FILTERED,
+    DDS_NUM_OUTPUTS
+} DDS_OUTPUT;
+
+// nothing is printed, a NULL context comes with a message in error unless error is NULL, DDS_pull does not allocate
+DDS_CONTEXT *DDS_create(const DDS_CONFIG *config, const char **error);
+int DDS_pull(DDS_CONTEXT *context, int n, const DDS_SAMPLES *samples);
+long long DDS_seek(DDS_CONTEXT *context, long long sample_index);
+void DDS_destroy(DDS_CONTEXT *context);
+
+// load the registers like the host interface of the chip does, values are taken modulo 2^N
+void DDS_set_frequency_tuning_word(DDS_CONTEXT *context, long long frequency_tuning_word);
+void DDS_set_phase_register(DDS_CONTEXT *context, long long phase);
+
+const DDS_CONFIG *DDS_get_config(const DDS_CONTEXT *context);
+double DDS_get_time(const DDS_CONTEXT *context);
+const char *DDS_get_frequency_tuning_word(const DDS_CONTEXT *context);
+const char *DDS_engine_name(DDS_ENGINE engine);
+const char *DDS_get_kernel_name(const DDS_CONTEXT *context);
+long long DDS_get_sample_count(const DDS_CONTEXT *context);
+void DDS_get_comparator_statistics(const DDS_CONTEXT *context, COMPARATOR_STATISTICS *statistics);
+void DDS_get_overflow_counters(const DDS_CONTEXT *context, FIXED_OVERFLOW_COUNTERS *counters);
+const ENVELOPE_PYRAMID *DDS_get_envelope(const DDS_CONTEXT *context, DDS_SIGNAL signal);
+const GATE_ACTIVITY *DDS_get_gate_activity(const DDS_CONTEXT *context);
+const ERROR_METRICS *DDS_get_error_metrics(const DDS_CONTEXT *context, DDS_OUTPUT output);
+
+// serialize into / restore from a checkpoint opened by the caller, which may store state of its own around it
+void DDS_put_checkpoint(const DDS_CONTEXT *context, CHECKPOINT_BUFFER *buffer);
+int DDS_get_checkpoint(DDS_CONTEXT *context, CHECKPOINT_BUFFER *buffer, const char **error);
+
+// completed envelope buckets are journaled instead, the caller appends the journal to a file before it writes the
+// checkpoint, and restores the journal up to the length it had then after DDS_get_checkpoint
+void DDS_put_envelope_journal(DDS_CONTEXT *context, CHECKPOINT_BUFFER *journal);
+int DDS_get_envelope_journal(DDS_CONTEXT *context, CHECKPOINT_BUFFER *journal, const char **error);
+
+#endif // DDS_H
@@ -0,0 +1,129 @@
+#include "dither.h"
+
+// splitmix64 output function evaluated at position counter of the stream selected by key
+static inline uint64_t counter_hash(uint64_t key, uint64_t counter) {
+    uint64_t z = counter * 0x9e3779b97f4a7c15ULL + key;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// returns 1 on success, 0 for an unknown mode or bit depths outside 1 <= dac_bit_depth <= N <= 62
+int PHASE_TRUNCATION_init(PHASE_TRUNCATION *stage, PHASE_TRUNCATION_MODE mode, int N, int dac_bit_depth,
+                          uint64_t seed) {
+    if (mode < PHASE_TRUNCATE || mode > PHASE_SHAPE_SECOND_ORDER || N < 1 || N > 62 || dac_bit_depth < 1
+        || dac_bit_depth > N) {
+        return 0;
+    }
+    stage->mode = mode;
+    stage->N = N;
+    stage->discarded_bits = N - dac_bit_depth;
+    stage->mask = (1ULL << N) - 1;
+    stage->low_mask = (1ULL << stage->discarded_bits) - 1;
+    stage->key = counter_hash(seed, 0x2545f4914f6cdd1dULL);
+    stage->counter = 0;
+    stage->error[0] = 0;
+    stage->error[1] = 0;
+    return 1;
+}
+
+// address receives the phase with its discarded bits cleared, phase and address may be the same array
+void PHASE_TRUNCATION_process(PHASE_TRUNCATION *stage, const long long *phase, int n, long long *address) {
+    const uint64_t mask = stage->mask, low_mask = stage->low_mask;
+    const int shift = 64 - stage->discarded_bits;
+
+    switch (stage->mode) {
+        case PHASE_TRUNCATE:
+            for (int k = 0; k < n; k++) {
+                address[k] = (long long)((uint64_t)phase[k] & mask & ~low_mask);
+            }
+            break;
+
+        case PHASE_DITHER:
+            if (stage->discarded_bits > 0) {
+                const uint64_t key = stage->key, counter = stage->counter;
+                for (int k = 0; k < n; k++) {
+                    uint64_t dither = counter_hash(key, counter + (uint64_t)k) >> shift;
+                    address[k] = (long long)(((uint64_t)phase[k] + dither) & mask & ~low_mask);
+                }
+            } else {
+                for (int k = 0; k < n; k++) {
+                    address[k] = (long long)((uint64_t)phase[k] & mask);
+                }
+            }
+            break;
+
+        case PHASE_SHAPE_FIRST_ORDER: {
+            uint64_t error1 = stage->error[0], error2 = stage->error[1];
+            for (int k = 0; k < n; k++) {
+                uint64_t value = ((uint64_t)phase[k] + error1) & mask;
+                error2 = error1;
+                error1 = value & low_mask;
+                address[k] = (long long)(value - error1);
+            }
+            stage->error[0] = error1;
+            stage->error[1] = error2;
+            break;
+        }
+
+        case PHASE_SHAPE_SECOND_ORDER: {
+            uint64_t error1 = stage->error[0], error2 = stage->error[1];
+            for (int k = 0; k < n; k++) {
+                uint64_t value = ((uint64_t)phase[k] + 2 * error1 - error2) & mask;
+                error2 = error1;
+                error1 = value & low_mask;
+                address[k] = (long long)(value - error1);
+            }
+            stage->error[0] = error1;
+            stage->error[1] = error2;
+            break;
+        }
+    }
+    stage->counter += (uint64_t)n;
+}
+
+// binomial coefficients modulo 2^64, the divisions are done on the factors before multiplying
+static uint64_t binomial2(uint64_t m) {
+    return m % 2 == 0 ? (m / 2) * (m - 1) : m * ((m - 1) / 2);
+}
+
+static uint64_t binomial3(uint64_t m) {
+    if (m < 3) return 0;
+    uint64_t factors[3] = {m, m - 1, m - 2};
+    factors[m % 3 == 0 ? 0 : m % 3 == 1 ? 1 : 2] /= 3;
+    factors[factors[0] % 2 == 0 ? 0 : 1] /= 2;
+    return factors[0] * factors[1] * factors[2];
+}
+
+// state after n samples of the phase ramp first_phase + k * frequency_tuning_word, without processing them. Modulo
+// 2^discarded_bits the fed back error is a running sum of the phase (first order) or a running sum of that running sum
+// (second order), which for a ramp has a closed form:
+//   first order   e[k] = e[-1] + (k + 1) a + C(k + 1, 2) f
+//   second order  e[k] = e[-1] + (k + 1) (e[-1] - e[-2]) + C(k + 2, 2) a + C(k + 2, 3) f
+void PHASE_TRUNCATION_advance(PHASE_TRUNCATION *stage, long long n, long long first_phase,
+                              long long frequency_tuning_word) {
+    if (n <= 0) return;
+    const uint64_t a = (uint64_t)first_phase, f = (uint64_t)frequency_tuning_word;
+    const uint64_t error1 = stage->error[0], error2 = stage->error[1];
+    uint64_t errors[2];
+
+    for (int i = 0; i < 2; i++) {
+        uint64_t k1 = (uint64_t)n - (uint64_t)i;  // k + 1 for the newest (k = n - 1) and the previous sample
+        switch (stage->mode) {
+            case PHASE_SHAPE_FIRST_ORDER:
+                errors[i] = error1 + k1 * a + binomial2(k1) * f;
+                break;
+            case PHASE_SHAPE_SECOND_ORDER:
+                errors[i] = error1 + k1 * (error1 - error2) + binomial2(k1 + 1) * a + binomial3(k1 + 1) * f;
+                break;
+            default:
+                errors[i] = 0;
+                break;
+        }
+    }
+    if (stage->mode == PHASE_SHAPE_FIRST_ORDER || stage->mode == PHASE_SHAPE_SECOND_ORDER) {
+        stage->error[0] = errors[0] & stage->low_mask;
+        stage->error[1] = errors[1] & stage->low_mask;
+    }
+    stage->counter += (uint64_t)n;
+}
@@ -0,0 +1,37 @@
+#ifndef DITHER_H
+#define DITHER_H
+#include <stdint.h>
+
+// PHASE TRUNCATION -----------------------------------------------------------------------------------------------------
+// stage between the phase accumulator and the ROM that drops the N - dac_bit_depth least significant bits of the phase.
+// Plain truncation leaves a periodic phase error and with it the classic truncation spurs, adding dither before
+// truncating or feeding the truncation error back trades them for a noise floor
+typedef enum {
+    PHASE_TRUNCATE,                // discard the low bits, as sin_ROM does
+    PHASE_DITHER,                  // add uniform dither over the discarded bits, then truncate
+    PHASE_SHAPE_FIRST_ORDER,       // error feedback, truncation error shaped by (1 - z^-1)
+    PHASE_SHAPE_SECOND_ORDER       // error feedback, truncation error shaped by (1 - z^-1)^2
+} PHASE_TRUNCATION_MODE;
+
+// the dither of sample k is a hash of the seed and k (counter-based), so every sample can be computed on its own: a
+// block is one loop without carried state, and a run split into time chunks gives the same samples as in one piece.
+// The error feedback modes carry two words of state, which PHASE_TRUNCATION_advance moves ahead in constant time
+// for a phase ramp, so they can be split into time chunks too
+typedef struct {
+    PHASE_TRUNCATION_MODE mode;
+    int N;                         // bit depth of phase
+    int discarded_bits;            // N - dac_bit_depth
+    uint64_t mask;                 // 2^N - 1
+    uint64_t low_mask;             // 2^discarded_bits - 1
+    uint64_t key;                  // derived from the seed
+    uint64_t counter;              // index of the next sample
+    uint64_t error[2];             // truncation errors of the last two samples, newest first
+} PHASE_TRUNCATION;
+
+int PHASE_TRUNCATION_init(PHASE_TRUNCATION *stage, PHASE_TRUNCATION_MODE mode, int N, int dac_bit_depth,
+                          uint64_t seed);
+void PHASE_TRUNCATION_process(PHASE_TRUNCATION *stage, const long long *phase, int n, long long *address);
+void PHASE_TRUNCATION_advance(PHASE_TRUNCATION *stage, long long n, long long first_phase,
+                              long long frequency_tuning_word);
+
+#endif // DITHER_H
@@ -0,0 +1,245 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "envelope.h"
+
+// ENVELOPE PYRAMID -----------------------------------------------------------------------------------------------------
+void ENVELOPE_PYRAMID_init(ENVELOPE_PYRAMID *pyramid, int base_size, int factor) {
+    memset(pyramid, 0, sizeof(ENVELOPE_PYRAMID));
+    pyramid->base_size = base_size < 1 ? 1 : base_size;
+    pyramid->factor = factor < 2 ? 2 : (factor > 16 ? 16 : factor);
+    pyramid->num_levels = 1;
+    pyramid->levels[0].bucket_size = pyramid->base_size;
+}
+
+// resize the arrays of a level to hold capacity buckets
+static int level_resize(ENVELOPE_LEVEL *level, long long capacity) {
+    double *new_time = (double *)realloc(level->time, capacity * sizeof(double));
+    if (new_time != NULL) level->time = new_time;
+    double *new_min = (double *)realloc(level->min, capacity * sizeof(double));
+    if (new_min != NULL) level->min = new_min;
+    double *new_max = (double *)realloc(level->max, capacity * sizeof(double));
+    if (new_max != NULL) level->max = new_max;
+    double *new_sum = (double *)realloc(level->sum, capacity * sizeof(double));
+    if (new_sum != NULL) level->sum = new_sum;
+
+    if (new_time == NULL || new_min == NULL || new_max == NULL || new_sum == NULL) {
+        return 0;
+    }
+    level->capacity = capacity;
+    return 1;
+}
+
+// allocate every level up front for a run of the given number of samples, so that adding samples never allocates,
+// samples beyond the reserve are counted in dropped instead of being added, returns 1 on success
+int ENVELOPE_PYRAMID_reserve(ENVELOPE_PYRAMID *pyramid, long long samples) {
+    pyramid->reserved = samples;
+    long long bucket_size = pyramid->base_size;
+    for (int i = 0; i < ENVELOPE_MAX_LEVELS && bucket_size <= samples; i++) {
+        ENVELOPE_LEVEL *level = &pyramid->levels[i];
+        level->bucket_size = bucket_size;
+        long long capacity = samples / bucket_size + 1;
+        if (capacity > level->capacity && !level_resize(level, capacity)) {
+            return 0;
+        }
+        bucket_size *= pyramid->factor;
+    }
+    return 1;
+}
+
+// append a completed bucket to a level, growing its arrays geometrically unless they were reserved
+static int level_append(ENVELOPE_LEVEL *level, bool reserved, double time, double min, double max, double sum) {
+    if (level->count == level->capacity
+        && (reserved || !level_resize(level, level->capacity > 0 ? 2 * level->capacity : 64))) {
+        return 0;
+    }
+
+    level->time[level->count] = time;
+    level->min[level->count] = min;
+    level->max[level->count] = max;
+    level->sum[level->count] = sum;
+    level->count++;
+    return 1;
+}
+
+// merge one child (a raw sample or a completed bucket of the level below) into the pending bucket of a level,
+// a completed bucket is stored and carried up into the next coarser level
+static void level_push(ENVELOPE_PYRAMID *pyramid, int index, double time, double min, double max, double sum) {
+    ENVELOPE_LEVEL *level = &pyramid->levels[index];
+
+    if (level->pending_children == 0) {
+        level->pending_time = time;
+        level->pending_min = min;
+        level->pending_max = max;
+        level->pending_sum = sum;
+    } else {
+        if (min < level->pending_min) level->pending_min = min;
+        if (max > level->pending_max) level->pending_max = max;
+        level->pending_sum += sum;
+    }
+    level->pending_children++;
+
+    int children_per_bucket = index == 0 ? pyramid->base_size : pyramid->factor;
+    if (level->pending_children < children_per_bucket) {
+        return;
+    }
+
+    level->pending_children = 0;
+    if (!level_append(level, pyramid->reserved > 0, level->pending_time, level->pending_min, level->pending_max,
+                      level->pending_sum)) {
+        return;
+    }
+
+    if (index + 1 >= ENVELOPE_MAX_LEVELS) {
+        return;
+    }
+    if (index + 1 == pyramid->num_levels) {
+        pyramid->levels[index + 1].bucket_size = level->bucket_size * pyramid->factor;
+        pyramid->num_levels++;
+    }
+    level_push(pyramid, index + 1, level->pending_time, level->pending_min, level->pending_max, level->pending_sum);
+}
+
+void ENVELOPE_PYRAMID_add(ENVELOPE_PYRAMID *pyramid, double time, double value) {
+    if (pyramid->reserved > 0 && pyramid->sample_count >= pyramid->reserved) {
+        pyramid->dropped++;
+        return;
+    }
+    pyramid->sample_count++;
+    level_push(pyramid, 0, time, value, value, value);
+}
+
+// index of the first bucket of a level starting at or after time t
+static long long lower_bound(const ENVELOPE_LEVEL *level, double t) {
+    long long low = 0;
+    long long high = level->count;
+    while (low < high) {
+        long long middle = low + (high - low) / 2;
+        if (level->time[middle] < t) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// start time of the samples after the completed buckets of a level, which sit in the pending bucket of the coarsest
+// level at or below it that has one, returns 0 if there are none
+static int pending_start(const ENVELOPE_PYRAMID *pyramid, int index, double *time) {
+    for (int i = index; i >= 0; i--) {
+        if (pyramid->levels[i].pending_children > 0) {
+            *time = pyramid->levels[i].pending_time;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// completed buckets [first, last) of a level overlapping [t_start, t_end), a bucket starting before t_start is
+// included if it reaches past it, t_end <= t_start selects the whole run
+static void window(const ENVELOPE_PYRAMID *pyramid, int index, double t_start, double t_end, long long *first,
+                   long long *last) {
+    const ENVELOPE_LEVEL *level = &pyramid->levels[index];
+    if (t_end <= t_start) {
+        *first = 0;
+        *last = level->count;
+        return;
+    }
+    *first = lower_bound(level, t_start);
+    *last = lower_bound(level, t_end);
+
+    // buckets are contiguous, so the one before first ends where the next bucket or the tail starts
+    double next_time;
+    if (*first > 0 && (*first < level->count ? level->time[*first] > t_start
+                                             : pending_start(pyramid, index, &next_time) && next_time > t_start)) {
+        (*first)--;
+    }
+}
+
+// finest level whose buckets inside [t_start, t_end] fit in pixel_width columns, t_end <= t_start selects the whole run
+int ENVELOPE_PYRAMID_select_level(const ENVELOPE_PYRAMID *pyramid, int pixel_width, double t_start, double t_end) {
+    for (int i = 0; i < pyramid->num_levels; i++) {
+        long long first, last;
+        window(pyramid, i, t_start, t_end, &first, &last);
+        if (last - first + 1 <= pixel_width) {  // one extra column for the partial bucket at the end of the run
+            return i;
+        }
+    }
+    return pyramid->num_levels - 1;
+}
+
+// write time, min, max and mean of every bucket of a level inside [t_start, t_end], levels beyond the coarsest export
+// the coarsest, returns the number of rows, -1 if pyramid is NULL or the file cannot be opened
+int ENVELOPE_PYRAMID_export(const ENVELOPE_PYRAMID *pyramid, const char *filename, int level_index, double t_start,
+                            double t_end) {
+    if (pyramid == NULL) {
+        return -1;
+    }
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        return -1;
+    }
+
+    int index = level_index < 0 ? 0 : (level_index >= pyramid->num_levels ? pyramid->num_levels - 1 : level_index);
+    const ENVELOPE_LEVEL *level = &pyramid->levels[index];
+    int whole_run = t_end <= t_start;
+
+    long long first, last;
+    window(pyramid, index, t_start, t_end, &first, &last);
+    int rows = 0;
+    for (long long i = first; i < last; i++) {
+        fprintf(file, "%.9f\t%.6f\t%.6f\t%.6f\n",
+                level->time[i], level->min[i], level->max[i], level->sum[i] / level->bucket_size);
+        rows++;
+    }
+
+    // samples not yet in a completed bucket of this level are spread over the pending buckets of it and finer levels
+    long long tail_samples = pyramid->sample_count - level->count * level->bucket_size;
+    if (tail_samples > 0) {
+        double tail_time = 0.0, tail_min = 0.0, tail_max = 0.0, tail_sum = 0.0;
+        int empty = 1;
+        for (int i = index; i >= 0; i--) {
+            const ENVELOPE_LEVEL *pending = &pyramid->levels[i];
+            if (pending->pending_children == 0) {
+                continue;
+            }
+            if (empty) {
+                tail_time = pending->pending_time;
+                tail_min = pending->pending_min;
+                tail_max = pending->pending_max;
+                tail_sum = pending->pending_sum;
+                empty = 0;
+            } else {
+                if (pending->pending_min < tail_min) tail_min = pending->pending_min;
+                if (pending->pending_max > tail_max) tail_max = pending->pending_max;
+                tail_sum += pending->pending_sum;
+            }
+        }
+        // the tail runs to the end of the run, so it also covers a window that starts inside it
+        if (!empty && (whole_run || (tail_time < t_end && (tail_time >= t_start || first == last)))) {
+            fprintf(file, "%.9f\t%.6f\t%.6f\t%.6f\n", tail_time, tail_min, tail_max, tail_sum / tail_samples);
+            rows++;
+        }
+    }
+
+    fclose(file);
+    return rows;
+}
+
+void ENVELOPE_PYRAMID_cleanup(ENVELOPE_PYRAMID *pyramid) {
+    for (int i = 0; i < ENVELOPE_MAX_LEVELS; i++) {  // reserved levels may not be in use yet
+        free(pyramid->levels[i].time);
+        free(pyramid->levels[i].min);
+        free(pyramid->levels[i].max);
+        free(pyramid->levels[i].sum);
+        pyramid->levels[i].time = NULL;
+        pyramid->levels[i].min = NULL;
+        pyramid->levels[i].max = NULL;
+        pyramid->levels[i].sum = NULL;
+        pyramid->levels[i].count = 0;
+        pyramid->levels[i].journaled = 0;
+        pyramid->levels[i].capacity = 0;
+    }
+}
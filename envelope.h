@@ -0,0 +1,46 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#define ENVELOPE_MAX_LEVELS 32 // enough levels for 2^32 buckets at the coarsest factor of 2
+
+// ENVELOPE LEVEL -------------------------------------------------------------------------------------------------------
+// one resolution of the pyramid, every completed bucket covers base_size * factor^level samples
+typedef struct {
+    long long bucket_size;  // number of samples per bucket
+    long long count;        // number of completed buckets
+    long long capacity;     // number of allocated buckets
+    double *time;           // time of first sample of each bucket, s
+    double *min;            // minimum of each bucket
+    double *max;            // maximum of each bucket
+    double *sum;            // sum of each bucket, mean is sum / bucket_size
+    long long journaled;    // completed buckets already appended to the checkpoint journal
+
+    // bucket under construction, built from completed buckets of the level below (raw samples for level 0)
+    int pending_children;
+    double pending_time;
+    double pending_min;
+    double pending_max;
+    double pending_sum;
+} ENVELOPE_LEVEL;
+
+// ENVELOPE PYRAMID -----------------------------------------------------------------------------------------------------
+// multi-resolution min/max/mean envelope built while samples are produced, so peaks and glitches survive decimation
+typedef struct {
+    int base_size;          // samples per bucket at level 0
+    int factor;             // each level is factor times coarser than the one below, 2 to 16
+    int num_levels;         // number of levels in use
+    long long sample_count; // number of samples added
+    long long reserved;     // samples memory was reserved for, 0 if the levels grow on demand
+    long long dropped;      // samples added beyond the reserve, left out of the envelope
+    ENVELOPE_LEVEL levels[ENVELOPE_MAX_LEVELS];
+} ENVELOPE_PYRAMID;
+
+void ENVELOPE_PYRAMID_init(ENVELOPE_PYRAMID *pyramid, int base_size, int factor);
+int ENVELOPE_PYRAMID_reserve(ENVELOPE_PYRAMID *pyramid, long long samples);
+void ENVELOPE_PYRAMID_add(ENVELOPE_PYRAMID *pyramid, double time, double value);
+int ENVELOPE_PYRAMID_select_level(const ENVELOPE_PYRAMID *pyramid, int pixel_width, double t_start, double t_end);
+int ENVELOPE_PYRAMID_export(const ENVELOPE_PYRAMID *pyramid, const char *filename, int level, double t_start,
+                            double t_end);
+void ENVELOPE_PYRAMID_cleanup(ENVELOPE_PYRAMID *pyramid);
+
+#endif // ENVELOPE_H
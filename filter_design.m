@@ -24,9 +24,9 @@ disp(a_z);
 %  Write numerator and denominator coefficients
 fileID = fopen('D:\graduate\vsCode\C\direct_digital_synthesis\table\coefficients.txt', 'w');
 fprintf(fileID, 'coefficients:\n');
-fprintf(fileID, '%f ', b_z);
+fprintf(fileID, '%.17g ', b_z);  % full precision, the poles are too close to the unit circle for %f
 fprintf(fileID, '\n');
-fprintf(fileID, '%f ', a_z);
+fprintf(fileID, '%.17g ', a_z);
 fprintf(fileID, '\n');
 fclose(fileID);
 
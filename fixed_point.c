@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "fixed_point.h"
+
+// Q FORMAT -------------------------------------------------------------------------------------------------------------
+int Q_FORMAT_word_length(Q_FORMAT format) {
+    return 1 + format.integer_bits + format.fraction_bits;
+}
+
+// parse "m.n" into Qm.n, returns 1 on success
+int Q_FORMAT_parse(const char *text, Q_FORMAT *format) {
+    int integer_bits, fraction_bits;
+    char end;
+    if (sscanf(text, "%d.%d%c", &integer_bits, &fraction_bits, &end) != 2 || integer_bits < 0 || fraction_bits < 0) {
+        return 0;
+    }
+    format->integer_bits = integer_bits;
+    format->fraction_bits = fraction_bits;
+    return 1;
+}
+
+// FIXED POINT DATAPATH -------------------------------------------------------------------------------------------------
+// shift right by shift bits with the given rounding, a negative shift is a left shift
+static inline int64_t round_shift(int64_t value, int shift, FIXED_ROUNDING rounding) {
+    if (shift <= 0) {
+        return value * ((int64_t)1 << -shift);
+    }
+
+    int64_t quotient = value >> shift;  // arithmetic shift, i.e. floor
+    int64_t remainder = value & (((int64_t)1 << shift) - 1);
+    int64_t half = (int64_t)1 << (shift - 1);
+    switch (rounding) {
+        case FIXED_ROUND_NEAREST:
+            return quotient + (remainder >= half);
+        case FIXED_ROUND_CONVERGENT:
+            return quotient + (remainder > half || (remainder == half && (quotient & 1)));
+        default:
+            return quotient;
+    }
+}
+
+// bring value into a signed word of word_length bits, counting values that do not fit
+static inline int64_t fit_word(int64_t value, int word_length, FIXED_OVERFLOW overflow, long long *overflow_count) {
+    int64_t max = ((int64_t)1 << (word_length - 1)) - 1;
+    int64_t min = -max - 1;
+    *overflow_count += value > max || value < min;
+
+    if (overflow == FIXED_OVERFLOW_SATURATE) {
+        return value > max ? max : (value < min ? min : value);
+    }
+
+    uint64_t mask = ((uint64_t)1 << word_length) - 1;
+    uint64_t sign = (uint64_t)1 << (word_length - 1);
+    return (int64_t)((((uint64_t)value & mask) ^ sign) - sign);  // sign extend the low bits
+}
+
+static int64_t quantize(double input, Q_FORMAT format, FIXED_ROUNDING rounding, FIXED_OVERFLOW overflow,
+                        long long *overflow_count) {
+    double scaled = ldexp(input, format.fraction_bits);
+    switch (rounding) {
+        case FIXED_ROUND_NEAREST:
+            scaled = floor(scaled + 0.5);
+            break;
+        case FIXED_ROUND_CONVERGENT:
+            scaled = nearbyint(scaled);  // default floating point rounding is ties to even
+            break;
+        default:
+            scaled = floor(scaled);
+            break;
+    }
+
+    // keep the conversion to integer defined, anything this large overflows every supported word length anyway
+    if (scaled > 0x1p62) scaled = 0x1p62;
+    if (scaled < -0x1p62) scaled = -0x1p62;
+
+    return fit_word((int64_t)scaled, Q_FORMAT_word_length(format), overflow, overflow_count);
+}
+
+// returns 1 if every word length fits the lanes of the block kernels: ROM and DAC words of at most 16 bits,
+// coefficient and accumulator words of at most 32 bits
+int FIXED_POINT_CONFIG_check(const FIXED_POINT_CONFIG *config) {
+    return Q_FORMAT_word_length(config->rom) <= 16 && Q_FORMAT_word_length(config->dac) <= 16
+           && Q_FORMAT_word_length(config->coefficient) <= 32 && Q_FORMAT_word_length(config->accumulator) <= 32;
+}
+
+// round int32 words right by shift bits, 0 < shift < 32, the mode is chosen once so that each loop is free of branches:
+// rounding adds an offset below the cut, half for nearest and half - 1 plus the lowest kept bit for convergent, and
+// then floors, the sums wrap in unsigned lanes and are exact as long as value + half fits the word
+static void round_block32(int32_t *words, int n, int shift, FIXED_ROUNDING rounding) {
+    const uint32_t half = (uint32_t)1 << (shift - 1);
+    switch (rounding) {
+        case FIXED_ROUND_NEAREST:
+            for (int k = 0; k < n; k++) {
+                words[k] = (int32_t)((uint32_t)words[k] + half) >> shift;
+            }
+            break;
+        case FIXED_ROUND_CONVERGENT:
+            for (int k = 0; k < n; k++) {
+                uint32_t word = (uint32_t)words[k];
+                words[k] = (int32_t)(word + half - 1 + ((word >> shift) & 1)) >> shift;
+            }
+            break;
+        default:
+            for (int k = 0; k < n; k++) {
+                words[k] >>= shift;
+            }
+            break;
+    }
+}
+
+// floor an unsigned lane holding a signed int64 by shift bits, 0 < shift < 64, vector units without a 64 bit arithmetic
+// shift still have the logical one
+static inline int64_t floor_shift64(uint64_t word, int shift) {
+    uint64_t sign = (uint64_t)0 - (word >> 63);
+    return (int64_t)((word >> shift) | (sign << (63 - shift) << 1));
+}
+
+// the same for int64 words, 0 < shift < 64
+static void round_block64(int64_t *words, int n, int shift, FIXED_ROUNDING rounding) {
+    const uint64_t half = (uint64_t)1 << (shift - 1);
+    switch (rounding) {
+        case FIXED_ROUND_NEAREST:
+            for (int k = 0; k < n; k++) {
+                words[k] = floor_shift64((uint64_t)words[k] + half, shift);
+            }
+            break;
+        case FIXED_ROUND_CONVERGENT:
+            for (int k = 0; k < n; k++) {
+                uint64_t word = (uint64_t)words[k];
+                words[k] = floor_shift64(word + half - 1 + ((word >> shift) & 1), shift);
+            }
+            break;
+        default:
+            for (int k = 0; k < n; k++) {
+                words[k] = floor_shift64((uint64_t)words[k], shift);
+            }
+            break;
+    }
+}
+
+// bring int32 values into words of word_length <= 16 bits, returns the number of values that did not fit
+static int fit_block16(const int32_t *values, int16_t *output, int n, int word_length, FIXED_OVERFLOW overflow) {
+    const int32_t max = ((int32_t)1 << (word_length - 1)) - 1;
+    const int32_t min = -max - 1;
+    int count = 0;
+    for (int k = 0; k < n; k++) {
+        count += (values[k] > max) | (values[k] < min);
+    }
+
+    if (overflow == FIXED_OVERFLOW_SATURATE) {
+        for (int k = 0; k < n; k++) {
+            int32_t value = values[k] < max ? values[k] : max;
+            output[k] = (int16_t)(value > min ? value : min);
+        }
+    } else {
+        const uint32_t mask = ((uint32_t)1 << word_length) - 1;
+        const uint32_t sign = (uint32_t)1 << (word_length - 1);
+        for (int k = 0; k < n; k++) {
+            output[k] = (int16_t)(int32_t)((((uint32_t)values[k] & mask) ^ sign) - sign);
+        }
+    }
+    return count;
+}
+
+// values beyond the int32 lanes are clamped before they are wrapped, every supported word overflows long before
+void FIXED_quantize_block(const double *input, int16_t *output, int n, Q_FORMAT format,
+                          FIXED_ROUNDING rounding, FIXED_OVERFLOW overflow, long long *overflow_count) {
+    const double scale = ldexp(1.0, format.fraction_bits);
+    const double bias = rounding == FIXED_ROUND_NEAREST ? 0.5 : 0.0;
+    const double round_even = 0x1.8p52;  // adding and subtracting it rounds |x| < 2^51 to nearest, ties to even
+    const int word_length = Q_FORMAT_word_length(format);
+    double scaled[FIXED_BLOCK_SIZE];
+    int32_t words[FIXED_BLOCK_SIZE];
+
+    for (int start = 0; start < n; start += FIXED_BLOCK_SIZE) {
+        int count = n - start < FIXED_BLOCK_SIZE ? n - start : FIXED_BLOCK_SIZE;
+        for (int k = 0; k < count; k++) {
+            double value = input[start + k] * scale + bias;
+            value = value < 0x1p31 - 1 ? value : 0x1p31 - 1;
+            scaled[k] = value > -0x1p31 ? value : -0x1p31;
+        }
+
+        if (rounding == FIXED_ROUND_CONVERGENT) {
+            for (int k = 0; k < count; k++) {
+                scaled[k] = (scaled[k] + round_even) - round_even;
+            }
+        }
+        for (int k = 0; k < count; k++) {
+            words[k] = (int32_t)scaled[k];  // truncates toward zero
+        }
+        if (rounding != FIXED_ROUND_CONVERGENT) {
+            // floor: one less where truncation went up, i.e. where value - word is negative, adding 0.0 turns -0.0
+            // into 0.0 and the sign bit is read without a compare
+            for (int k = 0; k < count; k++) {
+                double fraction = (scaled[k] - (double)words[k]) + 0.0;
+                uint64_t bits;
+                memcpy(&bits, &fraction, sizeof(bits));
+                words[k] -= (int32_t)(bits >> 63);
+            }
+        }
+        *overflow_count += fit_block16(words, output + start, count, word_length, overflow);
+    }
+}
+
+// convert words between formats in int32 lanes
+void FIXED_requantize_block(const int16_t *input, Q_FORMAT input_format, int16_t *output, int n, Q_FORMAT format,
+                            FIXED_ROUNDING rounding, FIXED_OVERFLOW overflow, long long *overflow_count) {
+    const int shift = input_format.fraction_bits - format.fraction_bits;
+    const int word_length = Q_FORMAT_word_length(format);
+    int32_t words[FIXED_BLOCK_SIZE];
+
+    if (shift < -15 || shift > 31) {  // beyond the lanes, cannot happen for words of at most 16 bits
+        long long count = 0;
+        for (int i = 0; i < n; i++) {
+            output[i] = (int16_t)fit_word(round_shift(input[i], shift, rounding), word_length, overflow, &count);
+        }
+        *overflow_count += count;
+        return;
+    }
+
+    for (int start = 0; start < n; start += FIXED_BLOCK_SIZE) {
+        int count = n - start < FIXED_BLOCK_SIZE ? n - start : FIXED_BLOCK_SIZE;
+        for (int k = 0; k < count; k++) {
+            words[k] = input[start + k];
+        }
+        if (shift > 0) {
+            round_block32(words, count, shift, rounding);
+        } else if (shift < 0) {
+            for (int k = 0; k < count; k++) {
+                words[k] *= (int32_t)1 << -shift;
+            }
+        }
+        *overflow_count += fit_block16(words, output + start, count, word_length, overflow);
+    }
+}
+
+double FIXED_to_double(int64_t value, Q_FORMAT format) {
+    return ldexp((double)value, -format.fraction_bits);
+}
+
+// FIXED POINT LOW-PASS FILTER ------------------------------------------------------------------------------------------
+// roots of c[0]*z^order + c[1]*z^(order-1) + ... + c[order] by Durand-Kerner iteration, returns 1 on convergence
+static int polynomial_roots(const double *c, int order, double complex *roots) {
+    for (int i = 0; i < order; i++) {
+        roots[i] = cpow(0.4 + 0.9 * I, i);
+    }
+
+    double largest_step = 0.0;
+    for (int iteration = 0; iteration < 1000; iteration++) {
+        largest_step = 0.0;
+        for (int i = 0; i < order; i++) {
+            double complex value = c[0];
+            for (int j = 1; j <= order; j++) {
+                value = value * roots[i] + c[j];
+            }
+            double complex denominator = c[0];
+            for (int j = 0; j < order; j++) {
+                if (j != i) denominator *= roots[i] - roots[j];
+            }
+            double complex step = value / denominator;
+            roots[i] -= step;
+            if (cabs(step) > largest_step) largest_step = cabs(step);
+        }
+        if (largest_step < 1e-14) {
+            return 1;
+        }
+    }
+    return largest_step < 1e-9;  // clustered roots stall at rounding noise
+}
+
+// take the root nearest to target out of roots (and its conjugate if it is complex), returns the coefficients
+// [1, c1, c2] of the monic second order (or first order if only a real root is left) factor in z^-1
+static void take_factor(double complex *roots, int *count, double complex target, double factor[3]) {
+    factor[0] = 1.0;
+    factor[1] = 0.0;
+    factor[2] = 0.0;
+    if (*count == 0) {
+        return;
+    }
+
+    int nearest = 0;
+    for (int i = 1; i < *count; i++) {
+        if (cabs(roots[i] - target) < cabs(roots[nearest] - target)) nearest = i;
+    }
+    double complex root = roots[nearest];
+    roots[nearest] = roots[--(*count)];
+
+    if (fabs(cimag(root)) > 1e-9 * (1.0 + cabs(root))) {
+        // complex, remove the conjugate too
+        int conjugate = 0;
+        for (int i = 1; i < *count; i++) {
+            if (cabs(roots[i] - conj(root)) < cabs(roots[conjugate] - conj(root))) conjugate = i;
+        }
+        roots[conjugate] = roots[--(*count)];
+        factor[1] = -2.0 * creal(root);
+        factor[2] = creal(root) * creal(root) + cimag(root) * cimag(root);
+        return;
+    }
+
+    // real, pair with the nearest remaining real root if there is one
+    factor[1] = -creal(root);
+    int partner = -1;
+    for (int i = 0; i < *count; i++) {
+        if (fabs(cimag(roots[i])) <= 1e-9 * (1.0 + cabs(roots[i]))
+            && (partner < 0 || cabs(roots[i] - root) < cabs(roots[partner] - root))) {
+            partner = i;
+        }
+    }
+    if (partner >= 0) {
+        double other = creal(roots[partner]);
+        roots[partner] = roots[--(*count)];
+        factor[1] = -(creal(root) + other);
+        factor[2] = creal(root) * other;
+    }
+}
+
+// factor b/a into second order sections, poles farthest from the unit circle come first and every pole pair is
+// matched with its nearest zeros, the overall gain is put into the first section, returns the number of sections
+static int design_sections(const double *b, const double *a, int order, double sections[][6]) {
+    double complex poles[FIXED_LPF_MAX_ORDER];
+    double complex zeros[FIXED_LPF_MAX_ORDER];
+    if (b[0] == 0.0 || !polynomial_roots(a, order, poles) || !polynomial_roots(b, order, zeros)) {
+        return 0;
+    }
+
+    int num_poles = order;
+    int num_zeros = order;
+    int num_sections = 0;
+    while (num_poles > 0) {
+        int farthest = 0;
+        for (int i = 1; i < num_poles; i++) {
+            if (fabs(cabs(poles[i]) - 1.0) > fabs(cabs(poles[farthest]) - 1.0)) farthest = i;
+        }
+        double complex pole = poles[farthest];
+
+        double *section = sections[num_sections++];
+        take_factor(poles, &num_poles, pole, section + 3);
+        take_factor(zeros, &num_zeros, pole, section);
+    }
+
+    double gain = b[0] / a[0];
+    for (int i = 0; i < 3; i++) {
+        sections[0][i] *= gain;
+    }
+    return num_sections;
+}
+
+// returns 1 on success, 0 if the order or formats are not supported or the filter cannot be factored into second
+// order sections
+int FIXED_LPF_init(FIXED_LPF *lpf, const double *b, const double *a, int order, const FIXED_POINT_CONFIG *config,
+                   FIXED_OVERFLOW_COUNTERS *counters) {
+    double sections[(FIXED_LPF_MAX_ORDER + 1) / 2][6];
+    if (order < 1 || order > FIXED_LPF_MAX_ORDER || a[0] == 0.0 || !FIXED_POINT_CONFIG_check(config)) {
+        return 0;
+    }
+
+    memset(lpf, 0, sizeof(FIXED_LPF));
+    lpf->config = *config;
+    lpf->num_sections = design_sections(b, a, order, sections);
+    if (lpf->num_sections == 0) {
+        return 0;
+    }
+
+    // a[0] is 1 and never multiplied, so it is neither quantized nor counted if the format cannot hold it
+    for (int i = 0; i < lpf->num_sections; i++) {
+        for (int j = 0; j < 3; j++) {
+            lpf->sections[i].b[j] = (int32_t)quantize(sections[i][j], config->coefficient, config->rounding,
+                                                      config->overflow, &counters->coefficient);
+        }
+        for (int j = 1; j < 3; j++) {
+            lpf->sections[i].a[j] = (int32_t)quantize(sections[i][3 + j], config->coefficient, config->rounding,
+                                                      config->overflow, &counters->coefficient);
+        }
+    }
+    return 1;
+}
+
+// the feed-forward part has no recursion and is computed for a whole chunk at once, only the feedback part runs
+// sample by sample
+static void biquad_block(FIXED_BIQUAD *section, const int32_t *x, int32_t *y, int count, Q_FORMAT input,
+                         const FIXED_POINT_CONFIG *config, long long *overflow_count) {
+    const FIXED_ROUNDING rounding = config->rounding;
+    const int coefficient_bits = config->coefficient.fraction_bits;
+    const int feed_forward_shift = coefficient_bits + input.fraction_bits - config->accumulator.fraction_bits;
+    const int accumulator_word = Q_FORMAT_word_length(config->accumulator);
+
+    int32_t extended[2 + FIXED_BLOCK_SIZE];  // x[k-2], x[k-1], chunk
+    int64_t feed_forward[FIXED_BLOCK_SIZE];
+
+    extended[0] = section->x_history[1];
+    extended[1] = section->x_history[0];
+    memcpy(extended + 2, x, count * sizeof(int32_t));
+
+    for (int k = 0; k < count; k++) {
+        feed_forward[k] = 0;
+    }
+    if (Q_FORMAT_word_length(config->coefficient) + Q_FORMAT_word_length(input) <= 32 && feed_forward_shift > 0
+        && feed_forward_shift < 31) {
+        // products fit int32 lanes (at most 2^30 in magnitude, so adding half keeps them in range), only the sum of the
+        // three taps is widened
+        int32_t products[FIXED_BLOCK_SIZE];
+        for (int j = 0; j < 3; j++) {
+            const int32_t coefficient = section->b[j];
+            const int32_t *tap = extended + 2 - j;
+            for (int k = 0; k < count; k++) {
+                products[k] = coefficient * tap[k];
+            }
+            round_block32(products, count, feed_forward_shift, rounding);
+            for (int k = 0; k < count; k++) {
+                feed_forward[k] += products[k];
+            }
+        }
+    } else if (feed_forward_shift > 0 && feed_forward_shift < 63) {
+        // 32 x 32 bit products in 64 bits: the unsigned product of the low words corrected for the signs, which
+        // needs only the unsigned 32 bit multiply every vector unit has
+        int64_t products[FIXED_BLOCK_SIZE];
+        for (int j = 0; j < 3; j++) {
+            const uint64_t coefficient = (uint32_t)section->b[j];
+            const uint64_t coefficient_sign = section->b[j] < 0 ? ~(uint64_t)0 : 0;
+            const int32_t *tap = extended + 2 - j;
+            for (int k = 0; k < count; k++) {
+                uint64_t word = (uint32_t)tap[k];
+                uint64_t product = coefficient * word;
+                product -= (coefficient_sign & word) << 32;
+                product -= ((uint64_t)(int64_t)(tap[k] >> 31) & coefficient) << 32;
+                products[k] = (int64_t)product;
+            }
+            round_block64(products, count, feed_forward_shift, rounding);
+            for (int k = 0; k < count; k++) {
+                feed_forward[k] += products[k];
+            }
+        }
+    } else {
+        for (int j = 0; j < 3; j++) {
+            const int64_t coefficient = section->b[j];
+            const int32_t *tap = extended + 2 - j;
+            for (int k = 0; k < count; k++) {
+                feed_forward[k] += round_shift(coefficient * tap[k], feed_forward_shift, rounding);
+            }
+        }
+    }
+
+    int64_t y1 = section->y_history[0];
+    int64_t y2 = section->y_history[1];
+    for (int k = 0; k < count; k++) {
+        int64_t accumulator = feed_forward[k]
+                              - round_shift(section->a[1] * y1, coefficient_bits, rounding)
+                              - round_shift(section->a[2] * y2, coefficient_bits, rounding);
+        y2 = y1;
+        y1 = fit_word(accumulator, accumulator_word, config->overflow, overflow_count);
+        y[k] = (int32_t)y1;
+    }
+
+    section->x_history[0] = extended[count + 1];
+    section->x_history[1] = extended[count];
+    section->y_history[0] = (int32_t)y1;
+    section->y_history[1] = (int32_t)y2;
+}
+
+void FIXED_LPF_filter_block(FIXED_LPF *lpf, const int16_t *x, int32_t *y, int n, FIXED_OVERFLOW_COUNTERS *counters) {
+    int32_t chunk[FIXED_BLOCK_SIZE];
+
+    for (int start = 0; start < n; start += FIXED_BLOCK_SIZE) {
+        int count = n - start < FIXED_BLOCK_SIZE ? n - start : FIXED_BLOCK_SIZE;
+
+        for (int k = 0; k < count; k++) {
+            chunk[k] = x[start + k];  // widen int16 DAC words to int32 lanes
+        }
+
+        Q_FORMAT input = lpf->config.dac;
+        for (int i = 0; i < lpf->num_sections; i++) {
+            biquad_block(&lpf->sections[i], chunk, chunk, count, input, &lpf->config, &counters->accumulator);
+            input = lpf->config.accumulator;
+        }
+
+        memcpy(y + start, chunk, count * sizeof(int32_t));
+    }
+}
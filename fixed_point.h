@@ -0,0 +1,79 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+#include <stdint.h>
+
+#define FIXED_BLOCK_SIZE 256    // samples processed per chunk by the block kernels
+#define FIXED_LPF_MAX_ORDER 16  // highest supported filter order
+
+// Q FORMAT -------------------------------------------------------------------------------------------------------------
+// signed two's complement Qm.n, word length is 1 + m + n bits
+typedef struct {
+    int integer_bits;   // m
+    int fraction_bits;  // n
+} Q_FORMAT;
+
+typedef enum {
+    FIXED_ROUND_TRUNCATE,    // towards minus infinity, i.e. dropping bits
+    FIXED_ROUND_NEAREST,     // to nearest, ties away from minus infinity
+    FIXED_ROUND_CONVERGENT   // to nearest, ties to even
+} FIXED_ROUNDING;
+
+typedef enum {
+    FIXED_OVERFLOW_SATURATE, // clamp to the largest representable value
+    FIXED_OVERFLOW_WRAP      // keep the low word length bits
+} FIXED_OVERFLOW;
+
+int Q_FORMAT_word_length(Q_FORMAT format);
+int Q_FORMAT_parse(const char *text, Q_FORMAT *format);
+
+// FIXED POINT DATAPATH -------------------------------------------------------------------------------------------------
+// ROM output and DAC input are at most 16 bits wide (int16 lanes), coefficients and accumulators at most 32 bits
+// (int32 lanes, products stay in int32 lanes when the two words fit 32 bits and are formed in 64 bits otherwise), the
+// block kernels choose the rounding and overflow modes outside their loops so that the compiler vectorizes them
+typedef struct {
+    Q_FORMAT rom;            // sine ROM output
+    Q_FORMAT coefficient;    // filter coefficients
+    Q_FORMAT accumulator;    // filter accumulator and output
+    Q_FORMAT dac;            // DAC input word
+    FIXED_ROUNDING rounding;
+    FIXED_OVERFLOW overflow;
+} FIXED_POINT_CONFIG;
+
+typedef struct {
+    long long rom;           // ROM outputs out of range
+    long long coefficient;   // filter coefficients out of range
+    long long accumulator;   // filter accumulator results out of range
+    long long dac;           // DAC input words out of range
+} FIXED_OVERFLOW_COUNTERS;
+
+int FIXED_POINT_CONFIG_check(const FIXED_POINT_CONFIG *config);
+
+void FIXED_quantize_block(const double *input, int16_t *output, int n, Q_FORMAT format,
+                          FIXED_ROUNDING rounding, FIXED_OVERFLOW overflow, long long *overflow_count);
+void FIXED_requantize_block(const int16_t *input, Q_FORMAT input_format, int16_t *output, int n, Q_FORMAT format,
+                            FIXED_ROUNDING rounding, FIXED_OVERFLOW overflow, long long *overflow_count);
+double FIXED_to_double(int64_t value, Q_FORMAT format);
+
+// FIXED POINT LOW-PASS FILTER ------------------------------------------------------------------------------------------
+// the transfer function is factored into second order sections, a direct form realization of the whole filter is
+// unstable at any coefficient word length up to 32 bits because its poles sit too close to the unit circle
+typedef struct {
+    int32_t b[3];
+    int32_t a[3];           // a[0] is not used, sections are normalized to a[0] = 1
+    int32_t x_history[2];   // x[k-1], x[k-2]
+    int32_t y_history[2];   // y[k-1], y[k-2]
+} FIXED_BIQUAD;
+
+// cascade of direct form I sections, every product is rounded to the accumulator format before the sum of a section is
+// saturated or wrapped to the accumulator word, the first section takes DAC input words
+typedef struct {
+    int num_sections;
+    FIXED_POINT_CONFIG config;
+    FIXED_BIQUAD sections[(FIXED_LPF_MAX_ORDER + 1) / 2];
+} FIXED_LPF;
+
+int FIXED_LPF_init(FIXED_LPF *lpf, const double *b, const double *a, int order, const FIXED_POINT_CONFIG *config,
+                   FIXED_OVERFLOW_COUNTERS *counters);
+void FIXED_LPF_filter_block(FIXED_LPF *lpf, const int16_t *x, int32_t *y, int n, FIXED_OVERFLOW_COUNTERS *counters);
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,95 @@
+#include <stddef.h>
+#include "kernel.h"
+
+#if defined(__GNUC__)
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE inline
+#endif
+
+// the body shared by all kernels, inlined into each of them with N, BITS and ORDER as constants, so that masks, shifts
+// and the DAC scale fold and the filter loops unroll. The operations are those of the generic stages in the same
+// order, which keeps the samples bit for bit identical (see regression.c)
+static KERNEL_INLINE void kernel_body(KERNEL_STATE *state, int n, long long *phase, double *rom_value,
+                                      double *dac_output, double *filtered_output, const int N, const int BITS,
+                                      const int ORDER) {
+    const uint32_t mask = (uint32_t)((1ULL << N) - 1);
+    const int shift = N - BITS;
+    const double full_scale = (double)((1 << BITS) - 1);  // pow(2, BITS) - 1, exactly
+    const double *rom_table = state->rom_table;
+    const double amplitude = state->amplitude;
+    const uint32_t delta_Phase = *state->delta_Phase;
+    uint32_t phase_register = *state->phase_register;
+
+    double b[KERNEL_MAX_ORDER + 1], a[KERNEL_MAX_ORDER + 1];
+    double x[KERNEL_MAX_ORDER + 1], y[KERNEL_MAX_ORDER + 1];
+    for (int i = 0; i <= ORDER; i++) {
+        b[i] = state->b[i];
+        a[i] = state->a[i];
+        x[i] = state->x_history[i];
+        y[i] = state->y_history[i];
+    }
+
+    for (int k = 0; k < n; k++) {
+        phase_register = (phase_register + delta_Phase) & mask;
+        phase[k] = phase_register;
+
+        double value = rom_table[phase_register >> shift];
+        rom_value[k] = value;
+
+        double dac = amplitude * value / full_scale;
+        dac_output[k] = dac;
+
+        for (int i = ORDER; i > 0; i--) {
+            x[i] = x[i - 1];
+            y[i] = y[i - 1];
+        }
+        x[0] = dac;
+        double out = 0.0;
+        for (int i = 0; i <= ORDER; i++) {
+            out += b[i] * x[i];
+        }
+        for (int i = 1; i <= ORDER; i++) {
+            out -= a[i] * y[i];
+        }
+        out /= a[0];
+        y[0] = out;
+        filtered_output[k] = out;
+    }
+
+    *state->phase_register = phase_register;
+    for (int i = 0; i <= ORDER; i++) {
+        state->x_history[i] = x[i];
+        state->y_history[i] = y[i];
+    }
+}
+
+#define KERNEL_DEFINE(N, BITS, ORDER)                                                                                 \
+    static void kernel_##N##_##BITS##_##ORDER(KERNEL_STATE *state, int n, long long *phase, double *rom_value,        \
+                                              double *dac_output, double *filtered_output) {                          \
+        kernel_body(state, n, phase, rom_value, dac_output, filtered_output, N, BITS, ORDER);                         \
+    }
+KERNEL_LIST(KERNEL_DEFINE)
+
+#define KERNEL_ENTRY(N, BITS, ORDER) {N, BITS, ORDER, "N" #N "_D" #BITS "_O" #ORDER, kernel_##N##_##BITS##_##ORDER},
+static const KERNEL kernels[] = {KERNEL_LIST(KERNEL_ENTRY)};
+
+#define NUM_KERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+// NULL if the combination has no kernel of its own and the generic stages have to run
+const KERNEL *KERNEL_select(int N, int dac_bit_depth, int filter_order) {
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        if (kernels[i].N == N && kernels[i].dac_bit_depth == dac_bit_depth && kernels[i].filter_order == filter_order) {
+            return &kernels[i];
+        }
+    }
+    return NULL;
+}
+
+int KERNEL_count(void) {
+    return NUM_KERNELS;
+}
+
+const KERNEL *KERNEL_get(int index) {
+    return index >= 0 && index < NUM_KERNELS ? &kernels[index] : NULL;
+}
@@ -0,0 +1,47 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+#include <stdint.h>
+
+// SPECIALIZED KERNELS --------------------------------------------------------------------------------------------------
+// (N, dac_bit_depth, filter_order) combinations of the production configurations, each X(...) line is compiled into a
+// kernel of its own, add a line to specialize another combination. Kernels exist for the word level engine with the
+// floating point datapath, ROM tables of up to 16 bits and plain phase truncation, other configurations run the
+// generic stages
+#define KERNEL_LIST(X) \
+    X(28, 10, 4)       \
+    X(28, 12, 4)       \
+    X(30, 14, 4)       \
+    X(24, 10, 4)       \
+    X(16, 8, 2)
+
+#define KERNEL_MAX_ORDER 16
+
+// state shared with the generic stages, so that a run may switch between a kernel and the generic path
+typedef struct {
+    uint32_t *phase_register;      // of the word level NCO
+    const uint32_t *delta_Phase;   // frequency tuning word
+    const double *rom_table;       // 2^dac_bit_depth samples
+    double amplitude;              // DAC full scale, V
+    const double *b;               // filter coefficients, order + 1 each
+    const double *a;
+    double *x_history;             // filter history, newest first
+    double *y_history;
+} KERNEL_STATE;
+
+// phase accumulator, ROM, DAC and low-pass filter over n samples in one pass
+typedef void (*KERNEL_FUNCTION)(KERNEL_STATE *state, int n, long long *phase, double *rom_value, double *dac_output,
+                                double *filtered_output);
+
+typedef struct {
+    int N;
+    int dac_bit_depth;
+    int filter_order;
+    const char *name;
+    KERNEL_FUNCTION function;
+} KERNEL;
+
+const KERNEL *KERNEL_select(int N, int dac_bit_depth, int filter_order);
+int KERNEL_count(void);
+const KERNEL *KERNEL_get(int index);
+
+#endif // KERNEL_H
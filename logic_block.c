@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "logic_block.h"
 
 // LOGIC GATES ----------------------------------------------------------------------------------------------------------
@@ -143,19 +144,21 @@ void N_BIT_ACCUMULATOR_init(N_BIT_ACCUMULATOR* accumulator, int n_bits, int logi
     accumulator->logic_id = logic_id;
     accumulator->n_bits = n_bits;
     accumulator->one_bit_accumulators = (ONE_BIT_ACCUMULATOR*)malloc(n_bits * sizeof(ONE_BIT_ACCUMULATOR));
+    accumulator->activity = NULL;
     for (int i = 0; i < n_bits; i++) {
         ONE_BIT_ACCUMULATOR_init(&accumulator->one_bit_accumulators[i], i);
     }
 }
 
+// working buffers live on the stack, so a clock tick never allocates
 void N_BIT_ACCUMULATOR_logic(N_BIT_ACCUMULATOR* accumulator, int clk, const char* y, int Cin, char* sum, int* Cout) {
-    int* bit_values = (int*)malloc(accumulator->n_bits * sizeof(int));
+    int bit_values[accumulator->n_bits];
 
     // Get length of the input string y
     int y_len = strlen(y);
     
+    char padded_y[accumulator->n_bits + 1];
     if (y_len < accumulator->n_bits) {
-        char* padded_y = (char*)malloc((accumulator->n_bits + 1) * sizeof(char));
         int padding_len = accumulator->n_bits - y_len;
         for (int i = 0; i < padding_len; i++) {
             padded_y[i] = '0';
@@ -171,14 +174,32 @@ void N_BIT_ACCUMULATOR_logic(N_BIT_ACCUMULATOR* accumulator, int clk, const char
         bit_values[accumulator->n_bits - 1 - i] = y[i] - '0';  // LSB to MSB
     }
 
-    char* sum_list = (char*)malloc(accumulator->n_bits + 1);
+    char sum_list[accumulator->n_bits + 1];
     int current_Cin = Cin;
+    // activity is recorded once per clock cycle, from the evaluation on the clock edge that latches the sum
+    GATE_ACTIVITY *activity = clk ? accumulator->activity : NULL;
+    uint64_t y_word = 0, q_word = 0, cin_word = 0, q_next_word = 0, rising_edge_word = 0;  // packed for activity
     for (int i = 0; i < accumulator->n_bits; i++) {
+        ONE_BIT_ACCUMULATOR* one_bit_accumulator = &accumulator->one_bit_accumulators[i];
+        if (activity != NULL) {
+            y_word |= (uint64_t)bit_values[i] << i;
+            q_word |= (uint64_t)one_bit_accumulator->Q << i;
+            cin_word |= (uint64_t)current_Cin << i;
+        }
+
         int sum1;
         int Cout1;
-        ONE_BIT_ACCUMULATOR_logic(&accumulator->one_bit_accumulators[i], clk, bit_values[i], current_Cin, &sum1, &Cout1);
+        ONE_BIT_ACCUMULATOR_logic(one_bit_accumulator, clk, bit_values[i], current_Cin, &sum1, &Cout1);
         sum_list[i] = sum1 + '0';
         current_Cin = Cout1;
+
+        if (activity != NULL) {
+            q_next_word |= (uint64_t)one_bit_accumulator->Q << i;
+            rising_edge_word |= (uint64_t)one_bit_accumulator->dflipflop.rising_edge << i;
+        }
+    }
+    if (activity != NULL) {
+        GATE_ACTIVITY_update(activity, y_word, q_word, cin_word, q_next_word, rising_edge_word);
     }
     sum_list[accumulator->n_bits] = '\0';
 
@@ -187,7 +208,20 @@ void N_BIT_ACCUMULATOR_logic(N_BIT_ACCUMULATOR* accumulator, int clk, const char
     }
     sum[accumulator->n_bits] = '\0';
     *Cout = current_Cin;
+}
+
+// parallel load of the flip-flops, value is MSB first, the next clock adds to it
+void N_BIT_ACCUMULATOR_load(N_BIT_ACCUMULATOR* accumulator, const char* value) {
+    if (accumulator->one_bit_accumulators == NULL) return;
+    for (int i = 0; i < accumulator->n_bits; i++) {
+        ONE_BIT_ACCUMULATOR* one_bit_accumulator = &accumulator->one_bit_accumulators[i];
+        one_bit_accumulator->dflipflop.Q = value[accumulator->n_bits - 1 - i] == '1';  // LSB to MSB
+        one_bit_accumulator->Q = one_bit_accumulator->dflipflop.Q;
+        one_bit_accumulator->nQ = !one_bit_accumulator->Q;
+    }
+}
 
-    free(bit_values);
-    free(sum_list);
+void N_BIT_ACCUMULATOR_cleanup(N_BIT_ACCUMULATOR* accumulator) {
+    free(accumulator->one_bit_accumulators);
+    accumulator->one_bit_accumulators = NULL;
 }
@@ -1,5 +1,6 @@
 #ifndef LOGIC_BLOCK_H
 #define LOGIC_BLOCK_H
+#include "activity.h"
 
 // LOGIC GATES ----------------------------------------------------------------------------------------------------------
 int logic_not(int A);
@@ -57,9 +58,12 @@ typedef struct {
     int logic_id;
     int n_bits;
     ONE_BIT_ACCUMULATOR* one_bit_accumulators;
+    GATE_ACTIVITY* activity;  // toggle counters, NULL when not instrumented
 } N_BIT_ACCUMULATOR;
 
 void N_BIT_ACCUMULATOR_init(N_BIT_ACCUMULATOR* accumulator, int n_bits, int logic_id);
 void N_BIT_ACCUMULATOR_logic(N_BIT_ACCUMULATOR* accumulator, int clk, const char* y, int Cin, char* result, int* Cout);
+void N_BIT_ACCUMULATOR_load(N_BIT_ACCUMULATOR* accumulator, const char* value);
+void N_BIT_ACCUMULATOR_cleanup(N_BIT_ACCUMULATOR* accumulator);
 
 #endif // LOGIC_BLOCK_H
@@ -14,115 +14,63 @@ Date: 2024.8.13
 ********************************************************************************************************************/
 
 #include <stdio.h>
-#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <complex.h>
-#include "logic_block.h"
-#include "nco.h"
-
-// #define M_PI 3.14159265358979323846
-#define filter_order 4 // low-pass filter order
-
-// Structure to store the simulation data
-typedef struct {
-    double *time;
-    double *phase;
-    double *dac_output;
-    double *sine_reference;
-    int *square_wave;
-} Data;
-
-typedef struct {
-    double last_remainder;
-} ROLLOVER;
-
-// Global constants
-double f_sampling = 120e6; // sampling frequency, is twice system clock frequency
-double f_output = 5e2;     // output frequency, not exceeding 0.4 * f_MCLK
-double f_cutoff = 1e5;     // cutoff frequency of low-pass filter
-double f_MCLK = 60e6;      // clock frequency
-int N = 28;                // bit depth of phase accumulator
-int dac_bit_depth = 10;    // bit depth of DAC
-
-void init_ROLLOVER(ROLLOVER *rollover) {
-    rollover->last_remainder = 0;
-}
-
-// True if rollover using modulo operation
-void check_rollover(ROLLOVER *rollover, double a, double n, bool *result) {
-
-    double this_remainder = fmod(a, n);
-    *result = this_remainder <= rollover->last_remainder;
-    rollover->last_remainder = this_remainder;
-}
-
-// Function to read coefficients from file
-void read_file(const char *filename, double **b, double **a, int *b_size, int *a_size) {
-    FILE *file = fopen(filename, "r");
-
-    if (file == NULL) {
-        fprintf(stderr, "Error: Unable to open the specified file.\n");
-        return EXIT_FAILURE;
-    }
-
-    fscanf(file, "coefficients:\n");
-
-    // numerator coefficients
-    *b = (double *)malloc(*b_size * sizeof(double));
-    for (int i = 0; i < *b_size; i++) {
-        fscanf(file, "%lf", &(*b)[i]);
-    }
-
-    // denominator coefficients
-    *a = (double *)malloc(*a_size * sizeof(double));
-    for (int i = 0; i < *a_size; i++) {
-        fscanf(file, "%lf", &(*a)[i]);
-    }
-
-    fclose(file);
-
-}
-
-// LPF design function implementation
-void LPF_design(double f_sampling, double **b, double **a) {
-
-    int b_size = filter_order + 1;
-    int a_size = filter_order + 1;
-
-    *b = (double *)malloc(b_size * sizeof(double));
-    *a = (double *)malloc(a_size * sizeof(double));
-
-    if (*b == NULL || *a == NULL) {
-        fprintf(stderr, "Error: Memory allocation failed.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    // Read the coefficients of numerator and denominator of discrete transfer function
-    const char *filepath = "D:/graduate/vsCode/C/direct_digital_synthesis/table/coefficients.txt";
-    read_file(filepath, b, a, &b_size, &a_size);
-
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "dds.h"
+#include "shm_ring.h"
+#include "multirate.h"
+
+#define PULL_SIZE 4096 // samples pulled from the synthesizer per call
+
+// Command line settings, the synthesizer itself is configured through DDS_CONFIG
+const char *coefficients_path = "table/coefficients.txt";
+const char *output_directory = "table";
+const char *checkpoint_path = NULL; // NULL writes checkpoint.bin into the output directory
+int plot_width = 1920;     // pixel width of plots, selects the exported envelope level
+double plot_start = 0.0;   // zoom window of the exported envelopes, s, plot_end <= plot_start exports the whole run
+double plot_end = 0.0;
+int plot_level = -1;       // exported envelope level, -1 selects it from plot_width
+const char *export_path = NULL; // pyramid file of an earlier run to export envelopes from instead of simulating
+long long checkpoint_interval = 0; // samples between periodic checkpoints, 0 disables them
+const char *shm_name = NULL; // shared memory ring publishing the samples to live consumers, NULL disables it
+int shm_blocks = 64;       // blocks of PULL_SIZE samples in the shared memory ring
+int interpolation_stages = 0; // half-band stages upsampling the DAC output by 2 each, 0 disables them
+int halfband_taps = 8;     // distinct coefficients of the first half-band stage
+int decimation_ratio = 0;  // CIC decimation ratio of the DAC output, 0 disables it
+int cic_order = 4;         // CIC integrator and comb sections
+int compensation_taps = 31; // taps of the CIC compensation filter
+bool decimated_analysis = false; // envelopes, comparator and error metrics analyse the decimated outputs
+double print_interval = 0.001; // time between parameter prints, s
+
+// Print the coefficients of numerator and denominator of discrete transfer function
+void print_transfer_function(const DDS_CONFIG *config) {
     printf("numerator coefficients of discrete transfer function (b):\n");
-    for (int i = 0; i < b_size; i++) {
-        printf("%lf ", (*b)[i]);
+    for (int i = 0; i <= config->filter_order; i++) {
+        printf("%lf ", config->b[i]);
     }
     printf("\n");
 
     // Print the denominator (a) coefficients
     printf("denominator coefficients of discrete transfer function (a):\n");
-    for (int i = 0; i < a_size; i++) {
-        printf("%lf ", (*a)[i]);
+    for (int i = 0; i <= config->filter_order; i++) {
+        printf("%lf ", config->a[i]);
     }
     printf("\n");
 
     printf("discrete transfer function:\n H(z) =\n");
 
-    for (int j = 0; j < b_size; j++) {
+    for (int j = 0; j <= config->filter_order; j++) {
         if (j > 0) {
             printf(" + ");
         }
-        printf("%lf*z^{- %d}", (*b)[j], j);
+        printf("%lf*z^{- %d}", config->b[j], j);
     }
 
     printf("\n");
@@ -132,192 +80,616 @@ void LPF_design(double f_sampling, double **b, double **a) {
     }
     printf("\n");
 
-    for (int j = 0; j < a_size; j++) {
+    for (int j = 0; j <= config->filter_order; j++) {
         if (j > 0) {
             printf(" + ");
         }
-        printf("%lf*z^{- %d}", (*a)[j], j);
+        printf("%lf*z^{- %d}", config->a[j], j);
     }
 
     printf("\n");
+}
+
+// Output state of the command line client, stored in front of the synthesizer state in every checkpoint
+typedef struct {
+    double last_print_time; // time of last parameter print, s
+    int64_t data_offset;    // bytes written to data file
+    int64_t interpolated_offset; // bytes written to interpolated data file
+    int64_t decimated_offset; // bytes written to decimated data file
+    int64_t journal_offset; // bytes written to envelope journal
+} OUTPUT_CURSOR;
+
+// Position of an output file in 64 bits, long is 32 bits on Windows, returns -1 on failure
+int64_t tell_output(FILE *file) {
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return ftello(file);
+#endif
+}
 
+// Open an output file, when resuming it is cut back to the bytes covered by the checkpoint, returns NULL on failure
+FILE *open_output(const char *directory, const char *name, bool resume, int64_t offset) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    FILE *file = fopen(path, resume ? "r+b" : "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Unable to open %s for writing.\n", path);
+        return NULL;
+    }
+    if (resume) {
+#ifdef _WIN32
+        int truncated = _chsize_s(_fileno(file), offset) == 0 && _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+        int truncated = ftruncate(fileno(file), (off_t)offset) == 0 && fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+        if (!truncated) {
+            fprintf(stderr, "Error: Unable to rewind %s to checkpoint.\n", path);
+            fclose(file);
+            return NULL;
+        }
+    }
+    return file;
 }
 
-// sin_ROM function implementation
-void sin_ROM(int N, char *address, int dac_bit_depth, char *dac_code, double *dac_value) {
-    strncpy(dac_code, address, dac_bit_depth);
-    dac_code[dac_bit_depth] = '\0';
+// Signals with an envelope, in DDS_SIGNAL order, as named in the exported files and in the pyramid file
+const char *const envelope_names[] = {"phase", "dac_output", "square_wave"};
+
+// Write an envelope at plot resolution or at plot_level, zoomed to the plot window if one is given, returns 1 on success
+int export_envelope(const ENVELOPE_PYRAMID *envelope, const char *name) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/envelope_%s.txt", output_directory, name);
+    int level = plot_level >= 0 ? plot_level
+                                : ENVELOPE_PYRAMID_select_level(envelope, plot_width, plot_start, plot_end);
+    if (ENVELOPE_PYRAMID_export(envelope, path, level, plot_start, plot_end) < 0) {
+        fprintf(stderr, "Error: Unable to open %s for writing.\n", path);
+        return 0;
+    }
+    return 1;
+}
 
-    char dac_code_makeupzero[N + 1];
-    strcpy(dac_code_makeupzero, dac_code);
+// Export the envelopes of a pyramid file saved by an earlier run, without simulating, returns 1 on success
+int export_saved_envelopes(const char *filename) {
+    CHECKPOINT_BUFFER buffer;
+    CHECKPOINT_BUFFER_init(&buffer);
+    const char *error;
+    int exported = CHECKPOINT_load(&buffer, filename, &error);
+    long long count = exported ? CHECKPOINT_get_int(&buffer) : 0;
+    if (exported && (buffer.error || count < 1 || count > DDS_NUM_SIGNALS)) {
+        error = "Pyramid file holds no envelopes";
+        exported = 0;
+    }
+    for (long long i = 0; exported && i < count; i++) {
+        char name[64];
+        CHECKPOINT_get_string(&buffer, name, sizeof(name));
+        int known = 0;
+        for (int j = 0; j < DDS_NUM_SIGNALS; j++) {
+            known |= strcmp(name, envelope_names[j]) == 0;
+        }
 
-    for (int i = dac_bit_depth; i < N; i++) {
-        dac_code_makeupzero[i] = '0';
+        ENVELOPE_PYRAMID envelope;
+        ENVELOPE_PYRAMID_init(&envelope, 1, 2);
+        error = "Pyramid file is corrupted";
+        exported = !buffer.error && known && CHECKPOINT_get_pyramid(&buffer, &envelope, &error);
+        if (exported) {
+            error = NULL;  // export_envelope reports its own failure
+            for (int j = 0; j < envelope.num_levels; j++) {
+                printf("envelope %s level %d: %lld samples per bucket, %lld buckets\n", name, j,
+                       envelope.levels[j].bucket_size, envelope.levels[j].count);
+            }
+            exported = export_envelope(&envelope, name);
+        }
+        ENVELOPE_PYRAMID_cleanup(&envelope);
     }
-    dac_code_makeupzero[N] = '\0';
+    if (!exported && error != NULL) {
+        fprintf(stderr, "Error: Unable to export envelopes from %s: %s.\n", filename, error);
+    }
+    CHECKPOINT_BUFFER_cleanup(&buffer);
+    return exported;
+}
 
-    int address_int = (int)strtol(dac_code_makeupzero, NULL, 2);
-    *dac_value = sin(2 * M_PI * address_int / (1 << N)) * (1 << dac_bit_depth);
+// Parse a Q format "m.n", returns 1 on success
+int parse_q_format(const char *text, Q_FORMAT *format) {
+    if (!Q_FORMAT_parse(text, format)) {
+        fprintf(stderr, "Error: Invalid Q format %s, expected m.n.\n", text);
+        return 0;
+    }
+    return 1;
 }
 
-// DAC function implementation
-double DAC(double A, double dac_value, int dac_bit_depth) {
-    return A * dac_value / (pow(2, dac_bit_depth) - 1);
+// Parse a rounding, overflow, engine or phase truncation name, returns 1 on success
+int parse_mode(const char *text, const char *const names[], int num_names, int *mode) {
+    for (int i = 0; i < num_names; i++) {
+        if (strcmp(text, names[i]) == 0) {
+            *mode = i;
+            return 1;
+        }
+    }
+    fprintf(stderr, "Error: Unknown mode %s.\n", text);
+    return 0;
 }
 
 // Main function
-int main() {
-
-    // TIME STEP AND RUN TIME -------------------------------------------------------------------------------------------
-    double time = 0.0;
-    double t_f = 10 * (1.0 / f_output);     // end time, s
-    // double t_f = 10000 * (1.0 / f_sampling);     // end time, s
-    double T_sampling = (1.0 / f_sampling); // sampling period, s
+int main(int argc, char *argv[]) {
+
+    DDS_CONFIG config;
+    DDS_CONFIG_default(&config);
+
+    // COMMAND LINE -----------------------------------------------------------------------------------------------------
+    const char *resume_path = NULL;
+    const char *const rounding_names[] = {"truncate", "nearest", "convergent"};
+    const char *const overflow_names[] = {"saturate", "wrap"};
+    const char *const engine_names[] = {"gate", "word"};
+    const char *const truncation_names[] = {"truncate", "dither", "shape1", "shape2"};
+    FIXED_POINT_CONFIG *fixed_point_config = &config.fixed_point_config;
+    int mode;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resume_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc) {
+            checkpoint_interval = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--coefficients") == 0 && i + 1 < argc) {
+            coefficients_path = argv[++i];
+        } else if (strcmp(argv[i], "--output-dir") == 0 && i + 1 < argc) {
+            output_directory = argv[++i];
+        } else if (strcmp(argv[i], "--plot-width") == 0 && i + 1 < argc) {
+            plot_width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--plot-start") == 0 && i + 1 < argc) {
+            plot_start = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--plot-end") == 0 && i + 1 < argc) {
+            plot_end = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--plot-level") == 0 && i + 1 < argc) {
+            plot_level = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--export-envelopes") == 0 && i + 1 < argc) {
+            export_path = argv[++i];
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--shm-blocks") == 0 && i + 1 < argc) {
+            shm_blocks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interpolate") == 0 && i + 1 < argc) {
+            interpolation_stages = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--halfband-taps") == 0 && i + 1 < argc) {
+            halfband_taps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--decimate") == 0 && i + 1 < argc) {
+            decimation_ratio = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cic-order") == 0 && i + 1 < argc) {
+            cic_order = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compensation-taps") == 0 && i + 1 < argc) {
+            compensation_taps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--decimated-analysis") == 0) {
+            decimated_analysis = true;
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            if (!parse_mode(argv[++i], engine_names, 2, &mode)) return EXIT_FAILURE;
+            config.engine = (DDS_ENGINE)mode;
+        } else if (strcmp(argv[i], "--phase-truncation") == 0 && i + 1 < argc) {
+            if (!parse_mode(argv[++i], truncation_names, 4, &mode)) return EXIT_FAILURE;
+            config.phase_truncation = (PHASE_TRUNCATION_MODE)mode;
+        } else if (strcmp(argv[i], "--dither-seed") == 0 && i + 1 < argc) {
+            config.dither_seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--no-kernels") == 0) {
+            config.specialized_kernels = false;
+        } else if (strcmp(argv[i], "--comparator-threshold") == 0 && i + 1 < argc) {
+            config.comparator_threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--comparator-hysteresis") == 0 && i + 1 < argc) {
+            config.comparator_hysteresis = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--accuracy") == 0) {
+            config.error_metrics = true;
+        } else if (strcmp(argv[i], "--fit-window") == 0 && i + 1 < argc) {
+            config.fit_window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--activity") == 0) {
+            config.gate_activity = true;
+        } else if (strcmp(argv[i], "--fixed-point") == 0) {
+            config.fixed_point = true;
+        } else if (strcmp(argv[i], "--q-rom") == 0 && i + 1 < argc) {
+            if (!parse_q_format(argv[++i], &fixed_point_config->rom)) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--q-coefficient") == 0 && i + 1 < argc) {
+            if (!parse_q_format(argv[++i], &fixed_point_config->coefficient)) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--q-accumulator") == 0 && i + 1 < argc) {
+            if (!parse_q_format(argv[++i], &fixed_point_config->accumulator)) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--q-dac") == 0 && i + 1 < argc) {
+            if (!parse_q_format(argv[++i], &fixed_point_config->dac)) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--rounding") == 0 && i + 1 < argc) {
+            if (!parse_mode(argv[++i], rounding_names, 3, &mode)) return EXIT_FAILURE;
+            fixed_point_config->rounding = (FIXED_ROUNDING)mode;
+        } else if (strcmp(argv[i], "--overflow") == 0 && i + 1 < argc) {
+            if (!parse_mode(argv[++i], overflow_names, 2, &mode)) return EXIT_FAILURE;
+            fixed_point_config->overflow = (FIXED_OVERFLOW)mode;
+        } else {
+            fprintf(stderr, "usage: %s [--resume FILE] [--checkpoint FILE] [--checkpoint-interval SAMPLES]\n"
+                            "          [--coefficients FILE] [--output-dir DIR] [--engine gate|word] [--no-kernels]\n"
+                            "          [--plot-width PIXELS] [--plot-start SECONDS] [--plot-end SECONDS]\n"
+                            "          [--plot-level LEVEL] [--export-envelopes FILE]\n"
+                            "          [--phase-truncation truncate|dither|shape1|shape2] [--dither-seed SEED]\n"
+                            "          [--comparator-threshold VOLTS] [--comparator-hysteresis VOLTS]\n"
+                            "          [--accuracy] [--fit-window SAMPLES] [--activity]\n"
+                            "          [--shm NAME] [--shm-blocks BLOCKS] [--interpolate STAGES] [--halfband-taps TAPS]\n"
+                            "          [--decimate RATIO] [--cic-order ORDER] [--compensation-taps TAPS] [--decimated-analysis]\n"
+                            "          [--fixed-point] [--q-rom M.N] [--q-coefficient M.N] [--q-accumulator M.N]\n"
+                            "          [--q-dac M.N] [--rounding truncate|nearest|convergent] [--overflow saturate|wrap]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
 
-    // Initialize simulation data  --------------------------------------------------------------------------------------
-    int num_sampling = (int)(t_f / T_sampling); // Calculate the number of sampling point
+    // envelopes of an earlier run are cut out of its pyramid file instead
+    if (export_path != NULL) {
+        return export_saved_envelopes(export_path) ? 0 : EXIT_FAILURE;
+    }
 
-    Data data;
-    data.time = (double *)malloc(num_sampling * sizeof(double));
-    data.phase = (double *)malloc(num_sampling * sizeof(double));
-    data.dac_output = (double *)malloc(num_sampling * sizeof(double));
-    data.sine_reference = (double *)malloc(num_sampling * sizeof(double));
-    data.square_wave = (int *)malloc(num_sampling * sizeof(double));
+    // TIME STEP AND RUN TIME -------------------------------------------------------------------------------------------
+    config.t_end = 10 * (1.0 / config.f_output);     // end time, s
+    // config.t_end = 10000 * (1.0 / config.f_sampling);     // end time, s
+    if (decimated_analysis) {
+        if (decimation_ratio <= 0) {
+            fprintf(stderr, "Error: --decimated-analysis needs --decimate.\n");
+            return EXIT_FAILURE;
+        }
+        config.analysis_decimation = decimation_ratio;
+        config.analysis_cic_order = cic_order;
+        config.analysis_compensation_taps = compensation_taps;
+    }
+    int analysis_ratio = decimated_analysis ? decimation_ratio : 1;  // samples per analysed sample
+    config.envelope_reserve = (long long)(config.t_end * config.f_MCLK / analysis_ratio) + 1;
 
     // PRINT ------------------------------------------------------------------------------------------------------------
-    // full scale current multiplied by shunt resistor resistance of 7-th order low-pass filter
-    double V_out = 10 * 1e-3 * 100;
-    double A = V_out; // amplitude of DAC output
-    double phi = 0; // phase offset
-    double delta_FSW = f_MCLK / (1 << N); // frequency resolution
+    double delta_FSW = config.f_MCLK / (1 << config.N); // frequency resolution
     printf("generated sine wave parameters:\n");
-    printf("amplitude (A): %.2f\n", A);
-    printf("frequency (f): %.2f Hz\n", f_output);
-    printf("phase offset (phi): %.2f rad\n", phi);
-    printf("sine wave: y(t) = %.2f * sin(2π * %.2f * t + %.2f)\n", A, f_output, phi);
+    printf("amplitude (A): %.2f\n", config.amplitude);
+    printf("frequency (f): %.2f Hz\n", config.f_output);
+    printf("phase offset (phi): %.2f rad\n", config.phase_offset);
+    printf("sine wave: y(t) = %.2f * sin(2π * %.2f * t + %.2f)\n", config.amplitude, config.f_output,
+           config.phase_offset);
     printf("frequency resolution: %.3f Hz\n", delta_FSW);
-
-    // RUN SIMULATION ---------------------------------------------------------------------------------------------------
-    int phase_address = 0;
-    double dac_output = 0.0;
-
-    NUMERICALLY_CONTROLLED_OSCILLATOR nco;
-    NCO_init(&nco, N, f_MCLK);
-
-    if (nco.phase_register == NULL || nco.delta_Phase == NULL) {
-        printf("NCO initialization failed.\n");
-        return 1;
+    printf("phase accumulator and ROM engine: %s\n", DDS_engine_name(config.engine));
+    if (config.phase_truncation != PHASE_TRUNCATE) {
+        printf("phase truncation: %s, seed %llu\n", truncation_names[config.phase_truncation],
+               (unsigned long long)config.dither_seed);
     }
 
-    NCO_set_output_frequency(&nco, f_output);
-
-    ROLLOVER rollover;
-    init_ROLLOVER(&rollover); // synchronize sampling and clock frequencies
-
-    // Coefficients of the numerator and denominator of discrete transfer function
-    int b_size = filter_order + 1;
-    int a_size = filter_order + 1;
-    double *b = (double*)malloc(b_size * sizeof(double));
-    double *a = (double*)malloc(a_size * sizeof(double));
-
-    // LPF design
-    LPF_design(f_sampling, &b, &a);
-
-    int m = filter_order; // numerator order of discrete transfer function
-    int n = filter_order; // denominator order of discrete transfer function
-
-    double print_interval = 0.001;
-    double last_print_time = 0.0;
-
-    ROLLOVER RO;
-    bool rollover_detected;
-
-    int i = 0;
-
-    while (time < t_f) {
-
-        check_rollover(&RO, time, (1.0 / f_MCLK), &rollover_detected);
-        if (rollover_detected) {  // If sampling frequency is synchronized with clock frequency
+    // LPF design, read the coefficients of numerator and denominator of discrete transfer function
+    const char *error;
+    if (!DDS_read_coefficients(&config, coefficients_path, &error)) {
+        fprintf(stderr, "Error: %s (%s).\n", error, coefficients_path);
+        return EXIT_FAILURE;
+    }
+    print_transfer_function(&config);
 
-            printf("\ntime = %.6f s\n", time);
+    // RUN SIMULATION ---------------------------------------------------------------------------------------------------
+    DDS_CONTEXT *dds = DDS_create(&config, &error);
+    if (dds == NULL) {
+        fprintf(stderr, "Error: %s.\n", error);
+        return EXIT_FAILURE;
+    }
+    printf("kernel: %s\n", DDS_get_kernel_name(dds));
+
+    // Multirate outputs, DAC output upsampled by half-band stages and decimated by a compensated CIC
+    static HALFBAND_INTERPOLATOR interpolator;
+    static CIC_DECIMATOR decimator;
+    if (interpolation_stages > 0 && !HALFBAND_INTERPOLATOR_init(&interpolator, interpolation_stages, halfband_taps)) {
+        fprintf(stderr, "Error: Half-band interpolator supports 0 to %d stages of 2 to %d taps.\n",
+                HALFBAND_MAX_STAGES, HALFBAND_MAX_TAPS);
+        DDS_destroy(dds);
+        return EXIT_FAILURE;
+    }
+    if (decimation_ratio > 0 && !CIC_DECIMATOR_init(&decimator, cic_order, decimation_ratio, compensation_taps, 0.2,
+                                                    2 * config.amplitude)) {
+        fprintf(stderr, "Error: Unsupported CIC decimator configuration (order %d, ratio %d, %d compensator taps).\n",
+                cic_order, decimation_ratio, compensation_taps);
+        DDS_destroy(dds);
+        return EXIT_FAILURE;
+    }
 
-            // Use the data output from phase accumulator as phase sampling address of waveform memory (ROM)
-            phase_address = NCO_phase_accumulator(&nco);
+    OUTPUT_CURSOR cursor = {0.0, 0, 0, 0, 0};
+
+    // Resume from checkpoint, the data file is cut back to the rows covered by the checkpoint
+    CHECKPOINT_BUFFER checkpoint, journal;
+    CHECKPOINT_BUFFER_init(&checkpoint);
+    CHECKPOINT_BUFFER_init(&journal);
+    char journal_path[1024];
+    snprintf(journal_path, sizeof(journal_path), "%s/envelope_journal.bin", output_directory);
+    if (resume_path != NULL) {
+        if (!CHECKPOINT_load(&checkpoint, resume_path, &error)) {
+            fprintf(stderr, "Error: Unable to resume from %s: %s.\n", resume_path, error);
+            return EXIT_FAILURE;
+        }
+        cursor.last_print_time = CHECKPOINT_get_double(&checkpoint);
+        cursor.data_offset = CHECKPOINT_get_int(&checkpoint);
+        cursor.interpolated_offset = CHECKPOINT_get_int(&checkpoint);
+        cursor.decimated_offset = CHECKPOINT_get_int(&checkpoint);
+        cursor.journal_offset = CHECKPOINT_get_int(&checkpoint);
+        error = "Checkpoint was written with different multirate outputs";
+        if (checkpoint.error || CHECKPOINT_get_int(&checkpoint) != interpolation_stages
+            || CHECKPOINT_get_int(&checkpoint) != decimation_ratio
+            || (interpolation_stages > 0 && !CHECKPOINT_get_interpolator(&checkpoint, &interpolator, &error))
+            || (decimation_ratio > 0 && !CHECKPOINT_get_decimator(&checkpoint, &decimator, &error))
+            || !DDS_get_checkpoint(dds, &checkpoint, &error)
+            || !CHECKPOINT_load_journal(&journal, journal_path, cursor.journal_offset, &error)
+            || !DDS_get_envelope_journal(dds, &journal, &error)) {
+            fprintf(stderr, "Error: Unable to resume from %s: %s.\n", resume_path, error);
+            return EXIT_FAILURE;
+        }
+        printf("resumed from %s at time = %.6f s, sample %lld\n", resume_path, DDS_get_time(dds),
+               DDS_get_sample_count(dds));
+    }
 
-            // Get DAC code and value from sin_ROM
-            char dac_code[N+1];
-            double dac_value;
-            sin_ROM(N, phase_address, dac_bit_depth, dac_code, &dac_value);
+    bool resume = resume_path != NULL;
+    FILE *file = open_output(output_directory, "data.txt", resume, cursor.data_offset);
+    FILE *interpolated_file = NULL;
+    FILE *decimated_file = NULL;
+    if (file == NULL
+        || (interpolation_stages > 0
+            && (interpolated_file = open_output(output_directory, "data_interpolated.txt", resume,
+                                                cursor.interpolated_offset)) == NULL)
+        || (decimation_ratio > 0
+            && (decimated_file = open_output(output_directory, "data_decimated.txt", resume,
+                                             cursor.decimated_offset)) == NULL)) {
+        return EXIT_FAILURE;
+    }
+    // envelope buckets completed between checkpoints are appended here instead of being stored in every checkpoint
+    FILE *journal_file = NULL;
+    if (checkpoint_interval > 0
+        && (journal_file = open_output(output_directory, "envelope_journal.bin", resume, cursor.journal_offset)) == NULL) {
+        return EXIT_FAILURE;
+    }
+    if (interpolation_stages > 0) {
+        printf("interpolating DAC output by %d, delay %.1f samples\n", 1 << interpolation_stages,
+               HALFBAND_INTERPOLATOR_delay(&interpolator));
+    }
+    // envelopes, comparator and error metrics analyse the full rate unless --decimated-analysis hands them the
+    // decimated outputs, which the synthesizer then produces with decimators of its own
+    if (decimation_ratio > 0) {
+        printf("decimating DAC output by %d, delay %.1f samples, to data_decimated.txt%s\n", decimation_ratio,
+               CIC_DECIMATOR_delay(&decimator), decimated_analysis ? " and the analysis stages" : " only");
+    }
 
-            // Calculate DAC output
-            dac_output = DAC(A, dac_value, dac_bit_depth);
-            printf("DAC output: %.4g\n", dac_output);
+    CHECKPOINT_WRITER checkpoint_writer;
+    char default_checkpoint_path[1024];
+    if (checkpoint_interval > 0) {
+        if (checkpoint_path == NULL) {
+            snprintf(default_checkpoint_path, sizeof(default_checkpoint_path), "%s/checkpoint.bin", output_directory);
+            checkpoint_path = default_checkpoint_path;
+        }
+        if (!CHECKPOINT_WRITER_init(&checkpoint_writer, checkpoint_path)) {
+            fprintf(stderr, "Error: Unable to start checkpoint writer thread.\n");
+            CHECKPOINT_WRITER_cleanup(&checkpoint_writer);
+            return EXIT_FAILURE;
+        }
+        printf("checkpoint every %lld samples to %s\n", checkpoint_interval, checkpoint_path);
+    }
 
-            // Reference sine wave
-            double sine_reference = A * sin(2 * M_PI * f_output * time + phi);
+    SHM_RING ring;
+    if (shm_name != NULL) {
+        if (!SHM_RING_create(&ring, shm_name, shm_blocks, PULL_SIZE, &error)) {
+            fprintf(stderr, "Error: %s (%s).\n", error, shm_name);
+            return EXIT_FAILURE;
+        }
+        printf("publishing samples to shared memory %s\n", shm_name);
+    }
 
-            // Square wave calculation
-            double average_voltage = 0.0;
-            int square_wave = dac_output > average_voltage ? 1 : 0;
+    static double time_buffer[PULL_SIZE], dac_output_buffer[PULL_SIZE], filtered_output_buffer[PULL_SIZE];
+    static long long phase_buffer[PULL_SIZE];
+    static int square_wave_buffer[PULL_SIZE];
+    DDS_SAMPLES samples = {.time = time_buffer, .phase = phase_buffer, .dac_output = dac_output_buffer,
+                           .filtered_output = filtered_output_buffer, .square_wave = square_wave_buffer};
+    static double interpolated[MULTIRATE_BLOCK_SIZE];
+    static double decimated[PULL_SIZE];
+    int N = config.N;
+    int dac_bit_depth = config.dac_bit_depth;
+
+    for (;;) {
+        // pull up to the next checkpoint, so that checkpoints land on multiples of the interval
+        long long request = PULL_SIZE;
+        if (checkpoint_interval > 0) {
+            long long to_checkpoint = checkpoint_interval - DDS_get_sample_count(dds) % checkpoint_interval;
+            if (to_checkpoint < request) request = to_checkpoint;
+        }
 
+        // with a shared memory ring the samples are produced straight into its next slot
+        if (shm_name != NULL) {
+            SHM_RING_begin_block(&ring, &samples);
+        }
+        int count = DDS_pull(dds, (int)request, &samples);
+        const double *time = samples.time;
+        const long long *phase = samples.phase;
+        const double *dac_output = samples.dac_output;
+        const double *filtered_output = samples.filtered_output;
+        const int *square_wave = samples.square_wave;
+
+        for (int k = 0; k < count; k++) {
             // Print parameters every 0.001 seconds
-            if (time - last_print_time >= print_interval) {
-                printf("time: %.3f s\n", time);
-                printf("phase address: %d\n", phase_address);
+            if (time[k] - cursor.last_print_time >= print_interval) {
+                char dac_code[dac_bit_depth + 1];
+                for (int j = 0; j < dac_bit_depth; j++) {
+                    dac_code[j] = (char)('0' + ((phase[k] >> (N - 1 - j)) & 1));
+                }
+                dac_code[dac_bit_depth] = '\0';
+
+                printf("time: %.3f s\n", time[k]);
+                printf("phase address: %lld\n", phase[k]);
                 printf("DAC code: %s\n", dac_code);
-                printf("DAC value: %.5g\n", dac_value);
-                printf("DAC output: %.3g\n", dac_output);
+                printf("DAC output: %.3g\n", dac_output[k]);
                 printf("-----------------------------------\n");
-                last_print_time = time;
+                cursor.last_print_time = time[k];
             }
 
             // Save data
-            data.time[i] = time;
-            data.phase[i] = phase_address;
-            data.dac_output[i] = dac_output;
-            data.sine_reference[i] = sine_reference;
-            data.square_wave[i] = square_wave;
+            fprintf(file, "%.6f\t%lld\t%.6f\t%d\t%.6f\n", time[k], phase[k], dac_output[k], square_wave[k],
+                    filtered_output[k]);
+        }
 
-            i++;
+        // Upsampled DAC output, in pieces that fit the interpolated buffer
+        int factor = 1 << interpolation_stages;
+        for (int start = 0; interpolation_stages > 0 && start < count; start += MULTIRATE_BLOCK_SIZE / factor) {
+            int piece = count - start < MULTIRATE_BLOCK_SIZE / factor ? count - start : MULTIRATE_BLOCK_SIZE / factor;
+            HALFBAND_INTERPOLATOR_process(&interpolator, dac_output + start, piece, interpolated);
+            for (int j = 0; j < piece * factor; j++) {
+                double t = time[start + j / factor] + (j % factor) / (config.f_MCLK * factor);
+                fprintf(interpolated_file, "%.9f\t%.6f\n", t, interpolated[j]);
+            }
         }
 
-        // Increment time
-        time += T_sampling;
-    }
+        // Decimated DAC output, each output is stamped with the time of the input that completed it
+        if (decimation_ratio > 0) {
+            int first = decimation_ratio - 1 - decimator.phase;
+            int outputs = CIC_DECIMATOR_process(&decimator, dac_output, count, decimated);
+            for (int j = 0; j < outputs; j++) {
+                fprintf(decimated_file, "%.6f\t%.6f\n", time[first + j * decimation_ratio], decimated[j]);
+            }
+        }
 
+        if (shm_name != NULL) {
+            SHM_RING_publish(&ring, count);
+        }
 
-    // Calculate duty cycle of square wave
-    int high_count = 0;
-    for (int i = 0; i < num_sampling; i++) {
-        if (data.square_wave[i] == 1) {
-            high_count++;
+        if (count < request) {
+            break;
         }
-    }
 
-    double duty_cycle = ((double)high_count / (double)num_sampling) * 2 * 100; // Percentage
-    printf("Duty cycle of square wave: %.4f%%\n", duty_cycle);
+        // Periodic checkpoint between two ticks, serialized here and written by the checkpoint writer thread
+        if (checkpoint_interval > 0 && DDS_get_sample_count(dds) % checkpoint_interval == 0) {
+            fflush(file);
+            cursor.data_offset = tell_output(file);
+            if (interpolated_file != NULL) {
+                fflush(interpolated_file);
+                cursor.interpolated_offset = tell_output(interpolated_file);
+            }
+            if (decimated_file != NULL) {
+                fflush(decimated_file);
+                cursor.decimated_offset = tell_output(decimated_file);
+            }
 
-    // Save data to file
-    FILE *file = fopen("D:/graduate/vsCode/C/direct_digital_synthesis/table/data.txt", "w");
-    if (file == NULL) {
-        fprintf(stderr, "Error: Unable to open data file for writing.\n");
-        return EXIT_FAILURE;
+            // the journal is on disk before the checkpoint that refers to it is submitted
+            CHECKPOINT_BUFFER_reset(&journal);
+            DDS_put_envelope_journal(dds, &journal);
+            if (journal.error || (journal.size > 0 && fwrite(journal.data, 1, journal.size, journal_file) != journal.size)
+                || fflush(journal_file) != 0) {
+                fprintf(stderr, "Error: Unable to write envelope journal %s.\n", journal_path);
+                return EXIT_FAILURE;
+            }
+            cursor.journal_offset = tell_output(journal_file);
+
+            CHECKPOINT_begin(&checkpoint);
+            CHECKPOINT_put_double(&checkpoint, cursor.last_print_time);
+            CHECKPOINT_put_int(&checkpoint, cursor.data_offset);
+            CHECKPOINT_put_int(&checkpoint, cursor.interpolated_offset);
+            CHECKPOINT_put_int(&checkpoint, cursor.decimated_offset);
+            CHECKPOINT_put_int(&checkpoint, cursor.journal_offset);
+            CHECKPOINT_put_int(&checkpoint, interpolation_stages);
+            CHECKPOINT_put_int(&checkpoint, decimation_ratio);
+            if (interpolation_stages > 0) {
+                CHECKPOINT_put_interpolator(&checkpoint, &interpolator);
+            }
+            if (decimation_ratio > 0) {
+                CHECKPOINT_put_decimator(&checkpoint, &decimator);
+            }
+            DDS_put_checkpoint(dds, &checkpoint);
+            CHECKPOINT_end(&checkpoint);
+            if (checkpoint.error) {
+                fprintf(stderr, "Error: Memory allocation failed for checkpoint.\n");
+            }
+            CHECKPOINT_WRITER_submit(&checkpoint_writer, &checkpoint);
+        }
     }
 
-    for (int i = 0; i < num_sampling; i++) {
-        fprintf(file, "%.6f\t%d\t%.6f\t%d\n",
-                data.time[i], (int)data.phase[i], data.dac_output[i], data.square_wave[i]);
+    fclose(file);
+    if (interpolated_file != NULL) fclose(interpolated_file);
+    if (decimated_file != NULL) fclose(decimated_file);
+    if (journal_file != NULL) fclose(journal_file);
+    if (shm_name != NULL) {
+        SHM_RING_CONSUMER_REPORT report;
+        for (int i = 0; i < SHM_RING_MAX_CONSUMERS; i++) {
+            if (SHM_RING_get_consumer(&ring, i, &report)) {
+                printf("consumer %d (pid %lld, %s): %llu blocks read, %llu blocks overrun\n", i, report.pid,
+                       report.attached ? "attached" : "detached", report.blocks_read, report.overruns);
+            }
+        }
+        SHM_RING_close(&ring);
+    }
+    if (checkpoint_interval > 0) {
+        CHECKPOINT_WRITER_cleanup(&checkpoint_writer);
+        printf("checkpoints written: %lld, replaced before writing: %lld, failed: %lld\n",
+               checkpoint_writer.written, checkpoint_writer.replaced, checkpoint_writer.failed);
+        if (checkpoint_writer.failed > 0) {
+            fprintf(stderr, "Error: Unable to write checkpoint file %s.\n", checkpoint_path);
+        }
+    }
+    CHECKPOINT_BUFFER_cleanup(&checkpoint);
+    CHECKPOINT_BUFFER_cleanup(&journal);
+
+    // Overflows of fixed point datapath
+    if (config.fixed_point) {
+        FIXED_OVERFLOW_COUNTERS overflow_counters;
+        DDS_get_overflow_counters(dds, &overflow_counters);
+        printf("fixed point overflows: ROM %lld, coefficients %lld, accumulator %lld, DAC %lld\n",
+               overflow_counters.rom, overflow_counters.coefficient, overflow_counters.accumulator,
+               overflow_counters.dac);
     }
 
-    fclose(file);
+    // Statistics of square wave
+    COMPARATOR_STATISTICS statistics;
+    DDS_get_comparator_statistics(dds, &statistics);
+    printf("Duty cycle of square wave: %.4f%%\n", statistics.duty_cycle);
+    printf("Zero crossings of square wave: %lld\n", statistics.crossing_count);
+    printf("Frequency of square wave: %.6f Hz (%lld periods)\n", statistics.frequency, statistics.period_count);
+    printf("Period jitter of square wave: %.4g s rms, %.4g s peak-to-peak\n",
+           statistics.jitter_rms, statistics.jitter_pp);
+
+    // Accuracy of outputs against the reference sine wave
+    const char *const output_names[] = {"DAC output", "filtered output"};
+    for (int i = 0; i < DDS_NUM_OUTPUTS; i++) {
+        const ERROR_METRICS *metrics = DDS_get_error_metrics(dds, (DDS_OUTPUT)i);
+        if (metrics == NULL) {
+            break;
+        }
+        ERROR_REPORT report;
+        ERROR_METRICS_get_report(metrics, &report);
+        printf("%s error: %.4g V rms, %.4g V peak over %lld samples\n", output_names[i], report.rms_error,
+               report.peak_error, report.count);
+        printf("%s sine fit: amplitude %.6f V, offset %.4g V, phase error %.6f rad, frequency error %.6f Hz "
+               "(%lld windows)\n", output_names[i], report.amplitude, report.offset, report.phase_error,
+               report.frequency_error, report.windows);
+    }
 
-    // Free allocated memory
-    free(data.time);
-    free(data.phase);
-    free(data.dac_output);
-    free(data.sine_reference);
-    free(data.square_wave);
+    // Save envelopes at plot resolution, zoomed to the plot window if one is given, and every level of them to a
+    // pyramid file, from which dds --export-envelopes cuts other levels and windows without running again
+    char path[1024];
+    CHECKPOINT_BUFFER pyramids;
+    CHECKPOINT_BUFFER_init(&pyramids);
+    CHECKPOINT_begin(&pyramids);
+    CHECKPOINT_put_int(&pyramids, DDS_get_envelope(dds, DDS_SIGNAL_PHASE) != NULL ? DDS_NUM_SIGNALS : 0);
+    for (int i = 0; i < DDS_NUM_SIGNALS; i++) {
+        const ENVELOPE_PYRAMID *envelope = DDS_get_envelope(dds, (DDS_SIGNAL)i);
+        if (envelope == NULL) {
+            continue;
+        }
+        export_envelope(envelope, envelope_names[i]);
+        if (envelope->dropped > 0) {
+            printf("envelope %s: %lld samples beyond the reserve left out\n", envelope_names[i], envelope->dropped);
+        }
+        CHECKPOINT_put_string(&pyramids, envelope_names[i]);
+        CHECKPOINT_put_pyramid(&pyramids, envelope);
+    }
+    CHECKPOINT_end(&pyramids);
+    snprintf(path, sizeof(path), "%s/envelopes.bin", output_directory);
+    if (DDS_get_envelope(dds, DDS_SIGNAL_PHASE) != NULL && !CHECKPOINT_save(&pyramids, path)) {
+        fprintf(stderr, "Error: Unable to write envelope pyramid file %s.\n", path);
+    }
+    CHECKPOINT_BUFFER_cleanup(&pyramids);
+
+    // Toggle activity of phase accumulator for power estimation
+    const GATE_ACTIVITY *activity = DDS_get_gate_activity(dds);
+    if (activity != NULL) {
+        char title[256];
+        snprintf(title, sizeof(title), "phase accumulator toggle activity, N = %d, FTW = %s",
+                 config.N, DDS_get_frequency_tuning_word(dds));
+        snprintf(path, sizeof(path), "%s/activity.txt", output_directory);
+        if (GATE_ACTIVITY_export(activity, path, title) < 0) {
+            fprintf(stderr, "Error: Unable to open %s for writing.\n", path);
+        }
+    }
 
-    getch();
+    DDS_destroy(dds);
     return 0;
 }
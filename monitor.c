@@ -0,0 +1,97 @@
+/********************************************************************************************************************
+DDS live monitor
+
+Attaches to the shared memory ring published by `dds --shm NAME` and reports the DAC and filtered output while the
+simulation runs, reading the sample blocks in place. It never slows down the simulation: if it falls behind, blocks
+are overwritten and reported as overruns. If the producer dies without closing the ring, or stops publishing for
+longer than --timeout seconds, the monitor gives up instead of waiting forever.
+********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "shm_ring.h"
+
+// sleep for the given number of microseconds
+void sleep_us(long microseconds) {
+    struct timespec duration = {microseconds / 1000000, (microseconds % 1000000) * 1000};
+    nanosleep(&duration, NULL);
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = "/dds";
+    long delay_us = 0;      // extra time spent per block, to emulate a slow consumer
+    int report_blocks = 64; // blocks between two reports
+    double timeout = 5.0;   // seconds without a new block before the producer counts as dead
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--delay-us") == 0 && i + 1 < argc) {
+            delay_us = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--report-blocks") == 0 && i + 1 < argc) {
+            report_blocks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            timeout = atof(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            name = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [NAME] [--delay-us MICROSECONDS] [--report-blocks BLOCKS] [--timeout SECONDS]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    SHM_RING ring;
+    const char *error;
+    if (!SHM_RING_attach(&ring, name, &error)) {
+        fprintf(stderr, "Error: %s (%s).\n", error, name);
+        return EXIT_FAILURE;
+    }
+    printf("attached to %s as consumer %d\n", name, ring.consumer);
+
+    long long samples = 0;
+    double sum_squares = 0.0, filtered_sum_squares = 0.0, last_time = 0.0;
+    long long block_count = 0;
+    SHM_RING_BLOCK block;
+
+    while (!SHM_RING_finished(&ring)) {
+        if (!SHM_RING_acquire(&ring, &block)) {
+            if (!SHM_RING_finished(&ring) && !SHM_RING_producer_alive(&ring, timeout)) {
+                fprintf(stderr, "Error: Producer of %s stopped without closing the ring.\n", name);
+                SHM_RING_close(&ring);
+                return EXIT_FAILURE;
+            }
+            sleep_us(1000);
+            continue;
+        }
+
+        // read in place, the result only counts if the block was not overwritten meanwhile
+        double block_sum_squares = 0.0, block_filtered_sum_squares = 0.0;
+        for (int k = 0; k < block.count; k++) {
+            block_sum_squares += block.dac_output[k] * block.dac_output[k];
+            block_filtered_sum_squares += block.filtered_output[k] * block.filtered_output[k];
+        }
+        double block_time = block.count > 0 ? block.time[block.count - 1] : last_time;
+        if (delay_us > 0) {
+            sleep_us(delay_us);
+        }
+
+        if (SHM_RING_release(&ring, &block)) {
+            samples += block.count;
+            sum_squares += block_sum_squares;
+            filtered_sum_squares += block_filtered_sum_squares;
+            last_time = block_time;
+        }
+
+        if (++block_count % report_blocks == 0) {
+            printf("time = %.6f s, samples = %lld, DAC output %.4f V rms, filtered output %.4f V rms, overruns = %lld\n",
+                   last_time, samples, samples > 0 ? sqrt(sum_squares / samples) : 0.0,
+                   samples > 0 ? sqrt(filtered_sum_squares / samples) : 0.0, ring.overruns);
+        }
+    }
+
+    printf("finished: %lld blocks read, %lld blocks overrun, %lld samples, DAC output %.4f V rms\n",
+           ring.blocks_read, ring.overruns, samples, samples > 0 ? sqrt(sum_squares / samples) : 0.0);
+    SHM_RING_close(&ring);
+    return 0;
+}
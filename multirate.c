@@ -0,0 +1,291 @@
+#include <string.h>
+#include <math.h>
+#include "multirate.h"
+
+// HALF-BAND INTERPOLATOR -----------------------------------------------------------------------------------------------
+// zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-17 * sum) break;
+    }
+    return sum;
+}
+
+// Kaiser windowed half-band filter of 4 * num_taps - 1 taps, keeps the taps of the filtering branch scaled by the
+// interpolation gain of 2, only the first num_taps are stored as the branch is symmetric
+static void design_halfband(HALFBAND_STAGE *stage, int num_taps) {
+    const double beta = 7.857;  // Kaiser window for 80 dB stopband attenuation
+    int length = 4 * num_taps - 1;
+    int center = 2 * num_taps - 1;
+
+    double sum = 0.0;
+    for (int m = 0; m < num_taps; m++) {
+        int offset = 2 * m - center;  // odd distance from the center tap
+        double ratio = (double)(2 * m) / (length - 1) * 2.0 - 1.0;
+        double window = bessel_i0(beta * sqrt(1.0 - ratio * ratio)) / bessel_i0(beta);
+        stage->taps[m] = 2.0 * sin(M_PI * offset / 2.0) / (M_PI * offset) * window;
+        sum += 2.0 * stage->taps[m];
+    }
+    for (int m = 0; m < num_taps; m++) {
+        stage->taps[m] /= sum;  // unity gain at DC
+    }
+    stage->num_taps = num_taps;
+}
+
+// num_taps is for the first stage, each following stage gets half as many down to 2, returns 1 on success
+int HALFBAND_INTERPOLATOR_init(HALFBAND_INTERPOLATOR *interpolator, int num_stages, int num_taps) {
+    memset(interpolator, 0, sizeof(HALFBAND_INTERPOLATOR));
+    if (num_stages < 0 || num_stages > HALFBAND_MAX_STAGES || num_taps < 2 || num_taps > HALFBAND_MAX_TAPS) {
+        return 0;
+    }
+    interpolator->num_stages = num_stages;
+    for (int s = 0; s < num_stages; s++) {
+        int stage_taps = num_taps >> s;
+        design_halfband(&interpolator->stages[s], stage_taps < 2 ? 2 : stage_taps);
+    }
+    return 1;
+}
+
+// n inputs to 2 * n outputs, n is at most MULTIRATE_BLOCK_SIZE / 2
+static void halfband_stage(HALFBAND_STAGE *stage, const double *input, int n, double *output) {
+    int K = stage->num_taps;
+    int span = 2 * K - 1;  // inputs kept from the previous block
+
+    double *work = stage->work;  // work[span + i] is input i
+    memcpy(work, stage->history, span * sizeof(double));
+    memcpy(work + span, input, n * sizeof(double));
+
+    for (int i = 0; i < n; i++) {
+        const double *x = work + i;  // x[span - m] is input i - m
+        double sum = 0.0;
+        for (int m = 0; m < K; m++) {
+            sum += stage->taps[m] * (x[span - m] + x[m]);
+        }
+        output[2 * i] = sum;
+        output[2 * i + 1] = x[K];  // center tap branch, input i - K + 1
+    }
+
+    memcpy(stage->history, work + n, span * sizeof(double));
+}
+
+// interpolate n inputs to n * 2^num_stages outputs, returns the number of outputs
+int HALFBAND_INTERPOLATOR_process(HALFBAND_INTERPOLATOR *interpolator, const double *input, int n, double *output) {
+    int S = interpolator->num_stages;
+    if (S == 0) {
+        memmove(output, input, n * sizeof(double));
+        return n;
+    }
+
+    int chunk = MULTIRATE_BLOCK_SIZE >> S;  // inputs per pass, so that no stage exceeds the block size
+    for (int start = 0; start < n; start += chunk) {
+        int count = n - start < chunk ? n - start : chunk;
+        const double *stage_input = input + start;
+        for (int s = 0; s < S; s++) {
+            double *stage_output = s == S - 1 ? output + ((long)start << S) : interpolator->buffers[s & 1];
+            halfband_stage(&interpolator->stages[s], stage_input, count << s, stage_output);
+            stage_input = stage_output;
+        }
+    }
+    return n << S;
+}
+
+// group delay of the cascade in output samples
+double HALFBAND_INTERPOLATOR_delay(const HALFBAND_INTERPOLATOR *interpolator) {
+    double delay = 0.0;
+    for (int s = 0; s < interpolator->num_stages; s++) {
+        // a stage delays by 2 * num_taps - 1 of its output samples, each of which is 2^(stages left) final samples
+        delay += (2.0 * interpolator->stages[s].num_taps - 1) * (1 << (interpolator->num_stages - 1 - s));
+    }
+    return delay;
+}
+
+// CIC DECIMATOR --------------------------------------------------------------------------------------------------------
+// magnitude of the CIC response at frequency f, as fraction of the output rate, normalized to one at DC
+static double cic_response(int order, int ratio, double f) {
+    if (f == 0.0) return 1.0;
+    return pow(fabs(sin(M_PI * f) / (ratio * sin(M_PI * f / ratio))), order);
+}
+
+// solve the n x n system matrix * x = vector in place by Gaussian elimination with partial pivoting
+static int solve(double *matrix, double *vector, int n) {
+    for (int column = 0; column < n; column++) {
+        int pivot = column;
+        for (int row = column + 1; row < n; row++) {
+            if (fabs(matrix[row * n + column]) > fabs(matrix[pivot * n + column])) pivot = row;
+        }
+        if (fabs(matrix[pivot * n + column]) < 1e-300) {
+            return 0;
+        }
+        if (pivot != column) {
+            for (int j = 0; j < n; j++) {
+                double swap = matrix[column * n + j];
+                matrix[column * n + j] = matrix[pivot * n + j];
+                matrix[pivot * n + j] = swap;
+            }
+            double swap = vector[column];
+            vector[column] = vector[pivot];
+            vector[pivot] = swap;
+        }
+        for (int row = column + 1; row < n; row++) {
+            double factor = matrix[row * n + column] / matrix[column * n + column];
+            for (int j = column; j < n; j++) {
+                matrix[row * n + j] -= factor * matrix[column * n + j];
+            }
+            vector[row] -= factor * vector[column];
+        }
+    }
+    for (int row = n - 1; row >= 0; row--) {
+        for (int j = row + 1; j < n; j++) {
+            vector[row] -= matrix[row * n + j] * vector[j];
+        }
+        vector[row] /= matrix[row * n + row];
+    }
+    return 1;
+}
+
+// least squares linear phase FIR with the inverse CIC response up to pass_band and zero response in the upper half
+// of the remaining band, the response at DC is one
+static int design_compensator(COMPENSATOR *compensator, int num_taps, int order, int ratio, double pass_band) {
+    enum { GRID = 1024 };
+    int P = (num_taps + 1) / 2;  // distinct coefficients
+    double matrix[(COMPENSATOR_MAX_TAPS + 1) / 2 * ((COMPENSATOR_MAX_TAPS + 1) / 2)] = {0};
+    double vector[(COMPENSATOR_MAX_TAPS + 1) / 2] = {0};
+    double stop_band = pass_band + (0.5 - pass_band) / 2;
+
+    for (int g = 0; g <= GRID; g++) {
+        double f = 0.5 * g / GRID;
+        double weight, target;
+        if (f <= pass_band) {
+            weight = 1.0;
+            target = 1.0 / cic_response(order, ratio, f);
+        } else if (f >= stop_band) {
+            weight = 0.1;
+            target = 0.0;
+        } else {
+            continue;
+        }
+
+        double basis[(COMPENSATOR_MAX_TAPS + 1) / 2];
+        basis[0] = 1.0;
+        for (int k = 1; k < P; k++) {
+            basis[k] = 2.0 * cos(2 * M_PI * f * k);
+        }
+        for (int i = 0; i < P; i++) {
+            for (int j = 0; j < P; j++) {
+                matrix[i * P + j] += weight * basis[i] * basis[j];
+            }
+            vector[i] += weight * basis[i] * target;
+        }
+    }
+    if (!solve(matrix, vector, P)) {
+        return 0;
+    }
+
+    double sum = vector[0];
+    for (int k = 1; k < P; k++) {
+        sum += 2.0 * vector[k];
+    }
+    compensator->num_taps = 2 * P - 1;
+    for (int k = 0; k < P; k++) {
+        compensator->taps[P - 1 - k] = vector[k] / sum;
+        compensator->taps[P - 1 + k] = vector[k] / sum;
+    }
+    return 1;
+}
+
+// filter n samples in place, n is at most MULTIRATE_BLOCK_SIZE
+static void compensator_block(COMPENSATOR *compensator, double *samples, int n) {
+    int span = compensator->num_taps - 1;
+    double *work = compensator->work;  // work[span + i] is sample i
+    memcpy(work, compensator->history, span * sizeof(double));
+    memcpy(work + span, samples, n * sizeof(double));
+
+    for (int i = 0; i < n; i++) {
+        const double *x = work + i;
+        double sum = 0.0;
+        for (int m = 0; m <= span; m++) {
+            sum += compensator->taps[m] * x[m];
+        }
+        samples[i] = sum;
+    }
+
+    memcpy(compensator->history, work + n, span * sizeof(double));
+}
+
+// compensation_taps is odd, 1 disables compensation, pass_band is a fraction of the output rate below 0.5,
+// returns 1 on success, 0 if the configuration is not supported or leaves fewer than 12 input bits
+int CIC_DECIMATOR_init(CIC_DECIMATOR *decimator, int order, int ratio, int compensation_taps, double pass_band,
+                       double full_scale) {
+    memset(decimator, 0, sizeof(CIC_DECIMATOR));
+    if (order < 1 || order > CIC_MAX_ORDER || ratio < 2 || compensation_taps < 1
+        || compensation_taps > COMPENSATOR_MAX_TAPS || compensation_taps % 2 == 0 || pass_band <= 0.0
+        || pass_band >= 0.5 || full_scale <= 0.0) {
+        return 0;
+    }
+
+    // register growth is order * log2(ratio) bits, the input gets what is left of 63 bits
+    int growth = (int)ceil(order * log2((double)ratio));
+    int input_bits = 63 - growth < 48 ? 63 - growth : 48;
+    if (input_bits < 12) {
+        return 0;
+    }
+
+    decimator->order = order;
+    decimator->ratio = ratio;
+    decimator->full_scale = full_scale;
+    decimator->scale = ldexp(1.0, input_bits - 1) / full_scale;
+    decimator->gain = 1.0 / (decimator->scale * pow(ratio, order));
+    decimator->pass_band = pass_band;
+
+    if (!design_compensator(&decimator->compensator, compensation_taps, order, ratio, pass_band)) {
+        return 0;
+    }
+    return 1;
+}
+
+// decimate n inputs, output needs room for n / ratio + 1 samples, returns the number of outputs
+int CIC_DECIMATOR_process(CIC_DECIMATOR *decimator, const double *input, int n, double *output) {
+    int M = decimator->order;
+    int count = 0;
+
+    for (int i = 0; i < n; i++) {
+        double x = input[i];
+        if (x > decimator->full_scale) x = decimator->full_scale;
+        if (x < -decimator->full_scale) x = -decimator->full_scale;
+
+        // integrators at the input rate, wrapping is harmless as the combs take differences
+        uint64_t value = (uint64_t)llround(x * decimator->scale);
+        for (int j = 0; j < M; j++) {
+            decimator->integrators[j] += value;
+            value = decimator->integrators[j];
+        }
+
+        if (++decimator->phase < decimator->ratio) {
+            continue;
+        }
+        decimator->phase = 0;
+
+        // combs at the output rate
+        for (int j = 0; j < M; j++) {
+            uint64_t previous = decimator->combs[j];
+            decimator->combs[j] = value;
+            value -= previous;
+        }
+        output[count++] = (double)(int64_t)value * decimator->gain;
+    }
+
+    for (int start = 0; start < count; start += MULTIRATE_BLOCK_SIZE) {
+        int chunk = count - start < MULTIRATE_BLOCK_SIZE ? count - start : MULTIRATE_BLOCK_SIZE;
+        compensator_block(&decimator->compensator, output + start, chunk);
+    }
+    return count;
+}
+
+// group delay of CIC and compensator in input samples
+double CIC_DECIMATOR_delay(const CIC_DECIMATOR *decimator) {
+    return decimator->order * (decimator->ratio - 1) / 2.0
+           + (decimator->compensator.num_taps - 1) / 2.0 * decimator->ratio;
+}
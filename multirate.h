@@ -0,0 +1,61 @@
+#ifndef MULTIRATE_H
+#define MULTIRATE_H
+#include <stdint.h>
+
+#define MULTIRATE_BLOCK_SIZE 4096    // largest number of samples a stage handles per pass
+#define HALFBAND_MAX_STAGES 6        // interpolation by up to 64
+#define HALFBAND_MAX_TAPS 16         // distinct coefficients of the filtering branch, i.e. up to 63 taps
+#define CIC_MAX_ORDER 6
+#define COMPENSATOR_MAX_TAPS 63
+
+// HALF-BAND INTERPOLATOR -----------------------------------------------------------------------------------------------
+// interpolation by 2 with a half-band filter of 4 * num_taps - 1 taps split into its two polyphase branches: every
+// other tap is zero and the center tap is one half, so even outputs take num_taps multiplies (symmetric taps folded)
+// and odd outputs are a delayed input, the zero-stuffed samples are never formed
+typedef struct {
+    int num_taps;                            // distinct coefficients, the filtering branch has 2 * num_taps taps
+    double taps[HALFBAND_MAX_TAPS];
+    double history[2 * HALFBAND_MAX_TAPS - 1];
+    double work[2 * HALFBAND_MAX_TAPS - 1 + MULTIRATE_BLOCK_SIZE / 2];
+} HALFBAND_STAGE;
+
+// cascade of half-band stages, interpolation by 2^num_stages, later stages see a narrower signal and get shorter
+typedef struct {
+    int num_stages;
+    HALFBAND_STAGE stages[HALFBAND_MAX_STAGES];
+    double buffers[2][MULTIRATE_BLOCK_SIZE]; // ping-pong between stages
+} HALFBAND_INTERPOLATOR;
+
+int HALFBAND_INTERPOLATOR_init(HALFBAND_INTERPOLATOR *interpolator, int num_stages, int num_taps);
+int HALFBAND_INTERPOLATOR_process(HALFBAND_INTERPOLATOR *interpolator, const double *input, int n, double *output);
+double HALFBAND_INTERPOLATOR_delay(const HALFBAND_INTERPOLATOR *interpolator);
+
+// CIC DECIMATOR --------------------------------------------------------------------------------------------------------
+// cascaded integrator-comb decimator followed by a linear phase FIR at the output rate that flattens the passband droop
+// of the CIC, the integrators work on wrapping 64-bit integers so that they never drift over long runs
+typedef struct {
+    int num_taps;
+    double taps[COMPENSATOR_MAX_TAPS];
+    double history[COMPENSATOR_MAX_TAPS - 1];
+    double work[COMPENSATOR_MAX_TAPS - 1 + MULTIRATE_BLOCK_SIZE];
+} COMPENSATOR;
+
+typedef struct {
+    int order;                               // number of integrator and comb sections
+    int ratio;                               // decimation ratio
+    int phase;                               // input samples since the last output
+    double scale;                            // integer steps per unit of input
+    double gain;                             // output per integer step, includes the CIC gain ratio^order
+    double full_scale;                       // largest input magnitude, larger inputs are clipped
+    uint64_t integrators[CIC_MAX_ORDER];
+    uint64_t combs[CIC_MAX_ORDER];           // previous input of each comb
+    double pass_band;                        // edge of the compensated passband, fraction of the output rate
+    COMPENSATOR compensator;
+} CIC_DECIMATOR;
+
+int CIC_DECIMATOR_init(CIC_DECIMATOR *decimator, int order, int ratio, int compensation_taps, double pass_band,
+                       double full_scale);
+int CIC_DECIMATOR_process(CIC_DECIMATOR *decimator, const double *input, int n, double *output);
+double CIC_DECIMATOR_delay(const CIC_DECIMATOR *decimator);
+
+#endif // MULTIRATE_H
@@ -8,6 +8,8 @@ void NCO_init(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, int N, int f_MCLK) {
     nco->f_MCLK = f_MCLK; // clock frequency
     nco->N = N; // bit depth of phase accumulator
     
+    nco->n_bit_accumulator.one_bit_accumulators = NULL; // nothing to free yet if allocation fails
+
     // Allocate memory for phase_register and delta_Phase
     nco->phase_register = (char*)malloc(N + 1);
     nco->delta_Phase = (char*)malloc(N + 1);
@@ -30,11 +32,10 @@ void NCO_init(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, int N, int f_MCLK) {
 }
 
 // next frequency tuning word delta_Phase is equal to output frequency divided by system clock frequency multiplied by 2 to the Nth power,
-// where N is the number of phase accumulator bits
-void NCO_set_output_frequency(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, double f_output) {
+// where N is the number of phase accumulator bits, returns 0 if the registers are not allocated
+int NCO_set_output_frequency(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, double f_output) {
     if (nco->phase_register == NULL || nco->delta_Phase == NULL) {
-        printf("Error: phase_register or delta_Phase is NULL.\n");
-        return;
+        return 0;
     }
     
     int new_delta_Phase = (int)((1 << nco->N) * (f_output / nco->f_MCLK));
@@ -58,13 +59,14 @@ void NCO_set_output_frequency(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, double f_o
 
     NCO_set_frequency_tuning_word(nco, nco->delta_Phase);
     // printf("delta_Phase: %s\n", nco->delta_Phase);
+    return 1;
 }
 
 // Set the frequency tuning word
 // at each clock pulse input, its output is increased by one step of phase increment value
 void NCO_set_frequency_tuning_word(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, const char* new_delta_Phase) {
     if (nco->delta_Phase == NULL) return;
-    strncpy(nco->delta_Phase, new_delta_Phase, nco->N);
+    memmove(nco->delta_Phase, new_delta_Phase, nco->N);  // NCO_set_output_frequency passes delta_Phase itself
     nco->delta_Phase[nco->N] = '\0';
 }
 
@@ -79,6 +81,7 @@ void NCO_set_phase_register(NUMERICALLY_CONTROLLED_OSCILLATOR* nco, const char*
     if (nco->phase_register == NULL) return;
     strncpy(nco->phase_register, last_phase, nco->N);
     nco->phase_register[nco->N] = '\0';
+    N_BIT_ACCUMULATOR_load(&nco->n_bit_accumulator, nco->phase_register);  // the flip-flops hold the phase
 }
 
 // Get the phase register
@@ -92,15 +95,15 @@ void NCO_reset_phase_register(NUMERICALLY_CONTROLLED_OSCILLATOR* nco) {
     if (nco->phase_register == NULL) return;
     memset(nco->phase_register, '0', nco->N);
     nco->phase_register[nco->N] = '\0';
+    N_BIT_ACCUMULATOR_load(&nco->n_bit_accumulator, nco->phase_register);
 }
 
 // Phase accumulator
 // phase accumulator emulates the mod-2*pi nature of the sinusoidal function by accumulating frequency tuning word and
-// overflowing it periodically using the mod-2^N operation of N-bit.
+// overflowing it periodically using the mod-2^N operation of N-bit, returns NULL if the registers are not allocated.
 const char* NCO_phase_accumulator(NUMERICALLY_CONTROLLED_OSCILLATOR* nco) {
     if (nco->phase_register == NULL || nco->delta_Phase == NULL) {
-        printf("Error: phase_register or delta_Phase is NULL.\n");
-        return;
+        return NULL;
     }
 
     nco->phase_register[nco->N] = '\0';
@@ -120,7 +123,7 @@ const char* NCO_phase_accumulator(NUMERICALLY_CONTROLLED_OSCILLATOR* nco) {
 
     N_BIT_ACCUMULATOR_logic(&nco->n_bit_accumulator, 0, "0", 0, next_address, &carry);
 
-    NCO_set_phase_register(nco, next_address);
+    memcpy(nco->phase_register, next_address, nco->N);  // the flip-flops already hold it
 
     return nco->phase_register;
 }
@@ -135,4 +138,29 @@ void NCO_cleanup(NUMERICALLY_CONTROLLED_OSCILLATOR* nco) {
         free(nco->delta_Phase);
         nco->delta_Phase = NULL;
     }
+    N_BIT_ACCUMULATOR_cleanup(&nco->n_bit_accumulator);
+}
+
+// WORD LEVEL NCO -------------------------------------------------------------------------------------------------------
+void WORD_NCO_init(WORD_NCO *nco, int N) {
+    nco->N = N;
+    nco->mask = N >= 32 ? 0xffffffffu : (1u << N) - 1;
+    nco->phase_register = 0;
+    nco->delta_Phase = 1;  // same as the gate level NCO after NCO_init
+}
+
+// takes the register contents of a gate level NCO, binary strings MSB first
+void WORD_NCO_load(WORD_NCO *nco, const char *phase_register, const char *delta_Phase) {
+    nco->phase_register = (uint32_t)strtoul(phase_register, NULL, 2) & nco->mask;
+    nco->delta_Phase = (uint32_t)strtoul(delta_Phase, NULL, 2) & nco->mask;
+}
+
+// n clock cycles, phase receives the register after each of them like NCO_phase_accumulator returns it
+void WORD_NCO_phase_accumulator(WORD_NCO *nco, int n, long long *phase) {
+    uint32_t phase_register = nco->phase_register;
+    for (int k = 0; k < n; k++) {
+        phase_register = (phase_register + nco->delta_Phase) & nco->mask;
+        phase[k] = phase_register;
+    }
+    nco->phase_register = phase_register;
 }
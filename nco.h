@@ -1,5 +1,6 @@
 #ifndef NCO_H
 #define NCO_H
+#include <stdint.h>
 #include "logic_block.h"
 
 // Structure for NCO
@@ -13,7 +14,7 @@ typedef struct{
 
 // Function prototypes
 void NCO_init(NUMERICALLY_CONTROLLED_OSCILLATOR *nco, int N, int f_MCLK);
-void NCO_set_output_frequency(NUMERICALLY_CONTROLLED_OSCILLATOR *nco, double f_output);
+int NCO_set_output_frequency(NUMERICALLY_CONTROLLED_OSCILLATOR *nco, double f_output);
 void NCO_set_frequency_tuning_word(NUMERICALLY_CONTROLLED_OSCILLATOR *nco, const char *new_delta_Phase);
 const char *NCO_get_frequency_tuning_word(const NUMERICALLY_CONTROLLED_OSCILLATOR *nco);
 void NCO_set_phase_register(NUMERICALLY_CONTROLLED_OSCILLATOR *nco, const char *last_phase);
@@ -22,4 +23,18 @@ void NCO_reset_phase_register(NUMERICALLY_CONTROLLED_OSCILLATOR *nco);
 const char *NCO_phase_accumulator(NUMERICALLY_CONTROLLED_OSCILLATOR *nco);
 void NCO_cleanup(NUMERICALLY_CONTROLLED_OSCILLATOR *nco);
 
+// WORD LEVEL NCO -------------------------------------------------------------------------------------------------------
+// the same phase accumulator as one integer addition modulo 2^N per clock cycle instead of N one bit accumulators,
+// bit-exact with the gate level model, which stays the reference it is checked against (see regression.c)
+typedef struct {
+    int N;                     // bit depth of phase accumulator, up to 32
+    uint32_t mask;             // 2^N - 1
+    uint32_t phase_register;
+    uint32_t delta_Phase;      // frequency tuning word
+} WORD_NCO;
+
+void WORD_NCO_init(WORD_NCO *nco, int N);
+void WORD_NCO_load(WORD_NCO *nco, const char *phase_register, const char *delta_Phase);
+void WORD_NCO_phase_accumulator(WORD_NCO *nco, int n, long long *phase);
+
 #endif // NCO_H
@@ -0,0 +1,801 @@
+/********************************************************************************************************************
+DDS regression
+
+Runs the gate level phase accumulator (N_BIT_ACCUMULATOR clocked by NCO_phase_accumulator), which is the reference,
+and the word level engine, with and without the specialized kernels of kernel.h, side by side over edge case and
+randomized tuning words, bit depths and phase seeds, and compares streaming FNV-1a hashes of the phase, ROM, DAC and
+filtered outputs bit for bit. Canonical configurations are also checked against the golden checksums in
+table/golden_checksums.txt, so that a change of the reference itself is noticed too. The golden checksums cover the
+outputs rounded well above the last bits that libm leaves to the platform. The floating point filter is left out of
+them, its poles close to z = 1 amplify a different rounding of one operation (FMA contraction, say) to about 1e-7 of
+full scale, beyond any rounding of the samples, while the fixed point filter is integer arithmetic and covered.
+
+Exits with a nonzero status on any mismatch. `--update` rewrites the golden checksums from the reference engine once
+both engines agree, `--cases` and `--seed` select the randomized cases.
+********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "dds.h"
+
+#define PIECE_SIZE 4096
+#define MAX_CANONICAL 16
+#define GOLDEN_OUTPUT_BITS 20 // fractional bits of full scale kept of the outputs in the golden checksums
+
+const char *golden_path = "table/golden_checksums.txt";
+const char *coefficients_path = "table/coefficients.txt";
+const char *const truncation_names[] = {"truncate", "dither", "shape1", "shape2"};
+
+// STREAMING HASHES -----------------------------------------------------------------------------------------------------
+typedef struct {
+    uint64_t phase;
+    uint64_t rom;
+    uint64_t dac;
+    uint64_t filtered;
+} SIGNAL_HASHES;
+
+void SIGNAL_HASHES_init(SIGNAL_HASHES *hashes) {
+    hashes->phase = hashes->rom = hashes->dac = hashes->filtered = 0xcbf29ce484222325ULL;
+}
+
+// FNV-1a over the bytes of the samples, doubles are hashed bit for bit
+void hash_bytes(uint64_t *hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t value = *hash;
+    for (size_t i = 0; i < size; i++) {
+        value ^= bytes[i];
+        value *= 0x100000001b3ULL;
+    }
+    *hash = value;
+}
+
+// FNV-1a over a 64-bit word, little-endian whatever the byte order of the host
+void hash_word(uint64_t *hash, uint64_t word) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(word >> (8 * i));
+    }
+    hash_bytes(hash, bytes, sizeof(bytes));
+}
+
+// hashes the samples rounded to multiples of full_scale / 2^bits
+void hash_rounded(uint64_t *hash, const double *samples, int n, double full_scale, int bits) {
+    double scale = ldexp(1.0, bits) / full_scale;
+    for (int k = 0; k < n; k++) {
+        hash_word(hash, (uint64_t)llround(samples[k] * scale));
+    }
+}
+
+int SIGNAL_HASHES_equal(const SIGNAL_HASHES *a, const SIGNAL_HASHES *b) {
+    return a->phase == b->phase && a->rom == b->rom && a->dac == b->dac && a->filtered == b->filtered;
+}
+
+void SIGNAL_HASHES_print_difference(const SIGNAL_HASHES *a, const SIGNAL_HASHES *b) {
+    printf("%s%s%s%s\n", a->phase != b->phase ? " phase" : "", a->rom != b->rom ? " ROM" : "",
+           a->dac != b->dac ? " DAC" : "", a->filtered != b->filtered ? " filtered" : "");
+}
+
+// RUNS -----------------------------------------------------------------------------------------------------------------
+// registers loaded before the first clock, a negative value keeps what the configuration implies
+typedef struct {
+    long long frequency_tuning_word;
+    long long phase_seed;
+} REGISTERS;
+
+// pulls the samples in uneven pieces so that the block boundaries of the library fall at varying offsets, hashes covers
+// the samples bit for bit, golden the portable form checked against the golden checksums unless it is NULL,
+// returns 0 if the synthesizer could not be created
+int run(const DDS_CONFIG *config, const REGISTERS *registers, long long num_samples, SIGNAL_HASHES *hashes,
+        SIGNAL_HASHES *golden) {
+    static const int piece_sizes[] = {1, 97, 256, 1000, PIECE_SIZE, 255, 3};
+    static double time[PIECE_SIZE], rom_output[PIECE_SIZE], dac_output[PIECE_SIZE], filtered_output[PIECE_SIZE];
+    static long long phase[PIECE_SIZE];
+    DDS_SAMPLES samples = {.time = time, .phase = phase, .dac_output = dac_output, .filtered_output = filtered_output,
+                           .rom_output = rom_output};
+
+    const char *error;
+    DDS_CONTEXT *dds = DDS_create(config, &error);
+    if (dds == NULL) {
+        printf("Error: %s.\n", error);
+        return 0;
+    }
+    if (registers->frequency_tuning_word >= 0) {
+        DDS_set_frequency_tuning_word(dds, registers->frequency_tuning_word);
+    }
+    if (registers->phase_seed >= 0) {
+        DDS_set_phase_register(dds, registers->phase_seed);
+    }
+
+    SIGNAL_HASHES_init(hashes);
+    if (golden != NULL) {
+        SIGNAL_HASHES_init(golden);
+    }
+    long long produced = 0;
+    for (int piece = 0; produced < num_samples; piece++) {
+        long long request = piece_sizes[piece % (sizeof(piece_sizes) / sizeof(piece_sizes[0]))];
+        if (request > num_samples - produced) request = num_samples - produced;
+        int count = DDS_pull(dds, (int)request, &samples);
+        if (count == 0) {
+            break;
+        }
+        hash_bytes(&hashes->phase, phase, count * sizeof(long long));
+        hash_bytes(&hashes->rom, rom_output, count * sizeof(double));
+        hash_bytes(&hashes->dac, dac_output, count * sizeof(double));
+        hash_bytes(&hashes->filtered, filtered_output, count * sizeof(double));
+        if (golden != NULL) {
+            for (int k = 0; k < count; k++) {
+                hash_word(&golden->phase, (uint64_t)phase[k]);
+            }
+            hash_rounded(&golden->rom, rom_output, count, ldexp(1.0, config->dac_bit_depth), GOLDEN_OUTPUT_BITS);
+            hash_rounded(&golden->dac, dac_output, count, config->amplitude, GOLDEN_OUTPUT_BITS);
+            if (config->fixed_point) {
+                hash_rounded(&golden->filtered, filtered_output, count, config->amplitude, GOLDEN_OUTPUT_BITS);
+            }
+        }
+        produced += count;
+    }
+
+    DDS_destroy(dds);
+    return 1;
+}
+
+// runs the gate level engine and the word level engine with and without specialized kernels, returns 1 if they all
+// agree, the golden checksums of the reference engine are returned unless golden is NULL
+int compare_engines(const char *label, DDS_CONFIG config, const REGISTERS *registers, long long num_samples,
+                    SIGNAL_HASHES *golden) {
+    static const struct {
+        DDS_ENGINE engine;
+        bool specialized_kernels;
+        const char *name;
+    } variants[] = {
+        {DDS_ENGINE_WORD, true, "word level engine"},
+        {DDS_ENGINE_WORD, false, "word level engine without kernels"},
+    };
+
+    SIGNAL_HASHES reference;
+    config.engine = DDS_ENGINE_GATE;
+    if (!run(&config, registers, num_samples, &reference, golden)) {
+        printf("FAIL %s: gate level engine could not be created\n", label);
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        SIGNAL_HASHES hashes;
+        config.engine = variants[i].engine;
+        config.specialized_kernels = variants[i].specialized_kernels;
+        if (!run(&config, registers, num_samples, &hashes, NULL)) {
+            printf("FAIL %s: %s could not be created\n", label, variants[i].name);
+            return 0;
+        }
+        if (!SIGNAL_HASHES_equal(&reference, &hashes)) {
+            printf("FAIL %s: %s differs in", label, variants[i].name);
+            SIGNAL_HASHES_print_difference(&reference, &hashes);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// splitmix64, the randomized cases are reproducible from the seed
+uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// DIFFERENTIAL CASES ---------------------------------------------------------------------------------------------------
+// tuning words and phase seeds at the corners of the accumulator: no increment, one LSB, half a turn, all ones
+int run_edge_cases(const DDS_CONFIG *base, int *num_cases) {
+    static const int bit_depths[] = {1, 2, 3, 4, 8, 12, 16, 24, 28, 30};
+    int failures = 0;
+
+    for (size_t i = 0; i < sizeof(bit_depths) / sizeof(bit_depths[0]); i++) {
+        int N = bit_depths[i];
+        long long mask = (1LL << N) - 1;
+        int dac_bit_depths[] = {1, N > 2 ? N / 2 : 1, N < 10 ? N : 10, N};
+        long long tuning_words[] = {0, 1, 1LL << (N - 1), mask, mask > 0 ? mask - 1 : 0, (1LL << (N - 1)) + 1};
+        long long seeds[] = {0, mask};
+
+        for (size_t d = 0; d < sizeof(dac_bit_depths) / sizeof(dac_bit_depths[0]); d++) {
+            DDS_CONFIG config = *base;
+            config.N = N;
+            config.dac_bit_depth = dac_bit_depths[d];
+            config.fixed_point = d % 2 == 1;
+            for (size_t f = 0; f < sizeof(tuning_words) / sizeof(tuning_words[0]); f++) {
+                for (size_t s = 0; s < sizeof(seeds) / sizeof(seeds[0]); s++) {
+                    REGISTERS registers = {tuning_words[f], seeds[s]};
+                    config.phase_truncation = (PHASE_TRUNCATION_MODE)((d + f + s) % 4);
+                    config.dither_seed = f;
+                    char label[200];
+                    snprintf(label, sizeof(label), "N = %d, dac bits = %d, FTW = 0x%llx, seed = 0x%llx, %s%s", N,
+                             config.dac_bit_depth, registers.frequency_tuning_word, registers.phase_seed,
+                             truncation_names[config.phase_truncation], config.fixed_point ? ", fixed point" : "");
+                    failures += !compare_engines(label, config, &registers, 300, NULL);
+                    (*num_cases)++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+int run_random_cases(const DDS_CONFIG *base, int count, uint64_t seed, int *num_cases) {
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        DDS_CONFIG config = *base;
+        config.N = 1 + (int)(next_random(&seed) % 30);
+        config.dac_bit_depth = 1 + (int)(next_random(&seed) % config.N);
+        config.fixed_point = next_random(&seed) & 1;
+        config.phase_truncation = (PHASE_TRUNCATION_MODE)(next_random(&seed) % 4);
+        config.dither_seed = next_random(&seed);
+        long long mask = (1LL << config.N) - 1;
+        REGISTERS registers = {(long long)(next_random(&seed) & mask), (long long)(next_random(&seed) & mask)};
+
+        char label[200];
+        snprintf(label, sizeof(label), "random case %d: N = %d, dac bits = %d, FTW = 0x%llx, seed = 0x%llx, %s%s", i,
+                 config.N, config.dac_bit_depth, registers.frequency_tuning_word, registers.phase_seed,
+                 truncation_names[config.phase_truncation], config.fixed_point ? ", fixed point" : "");
+        failures += !compare_engines(label, config, &registers, 1000, NULL);
+        (*num_cases)++;
+    }
+    return failures;
+}
+
+// every specialized kernel against the reference, the dispatcher has to pick it for its own configuration
+int run_kernel_cases(const DDS_CONFIG *base, uint64_t seed, int *num_cases) {
+    int failures = 0;
+    for (int i = 0; i < KERNEL_count(); i++) {
+        const KERNEL *kernel = KERNEL_get(i);
+        DDS_CONFIG config = *base;
+        config.N = kernel->N;
+        config.dac_bit_depth = kernel->dac_bit_depth;
+        if (kernel->filter_order != base->filter_order) {
+            // any stable filter of that order will do
+            config.filter_order = kernel->filter_order;
+            for (int j = 0; j <= config.filter_order; j++) {
+                config.b[j] = 1.0 / (config.filter_order + 1);
+                config.a[j] = j == 0 ? 1.0 : j == 1 ? -0.5 : 0.0;
+            }
+        }
+
+        config.engine = DDS_ENGINE_WORD;
+        DDS_CONTEXT *dds = DDS_create(&config, NULL);
+        if (dds == NULL || strcmp(DDS_get_kernel_name(dds), kernel->name) != 0) {
+            printf("FAIL kernel %s is not selected for its configuration\n", kernel->name);
+            failures++;
+        }
+        DDS_destroy(dds);
+
+        long long mask = (1LL << config.N) - 1;
+        for (int j = 0; j < 10; j++) {
+            REGISTERS registers = {j == 0 ? 1 : j == 1 ? mask : (long long)(next_random(&seed) & mask),
+                                   (long long)(next_random(&seed) & mask)};
+            char label[160];
+            snprintf(label, sizeof(label), "kernel %s: FTW = 0x%llx, seed = 0x%llx", kernel->name,
+                     registers.frequency_tuning_word, registers.phase_seed);
+            failures += !compare_engines(label, config, &registers, 2000, NULL);
+            (*num_cases)++;
+        }
+    }
+    return failures;
+}
+
+// the state PHASE_TRUNCATION_advance jumps to must be the one reached by processing the phase ramp in pieces, which
+// is what lets a run be split into time chunks
+int run_advance_cases(int count, uint64_t seed, int *num_cases) {
+    static long long phase[PIECE_SIZE], address[PIECE_SIZE];
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        int N = 1 + (int)(next_random(&seed) % 30);
+        int dac_bit_depth = 1 + (int)(next_random(&seed) % N);
+        PHASE_TRUNCATION_MODE mode = (PHASE_TRUNCATION_MODE)(1 + next_random(&seed) % 3);
+        long long mask = (1LL << N) - 1;
+        long long frequency_tuning_word = (long long)(next_random(&seed) & mask);
+        long long first_phase = (long long)(next_random(&seed) & mask);
+        long long num_samples = 1 + (long long)(next_random(&seed) % 20000);
+
+        PHASE_TRUNCATION processed, advanced;
+        PHASE_TRUNCATION_init(&processed, mode, N, dac_bit_depth, next_random(&seed));
+        processed.error[0] = next_random(&seed) & processed.low_mask;
+        processed.error[1] = next_random(&seed) & processed.low_mask;
+        advanced = processed;
+
+        long long next_phase = first_phase;
+        for (long long done = 0; done < num_samples;) {
+            int count_piece = num_samples - done < PIECE_SIZE ? (int)(num_samples - done) : PIECE_SIZE;
+            for (int k = 0; k < count_piece; k++) {
+                phase[k] = next_phase;
+                next_phase = (next_phase + frequency_tuning_word) & mask;
+            }
+            PHASE_TRUNCATION_process(&processed, phase, count_piece, address);
+            done += count_piece;
+        }
+        PHASE_TRUNCATION_advance(&advanced, num_samples, first_phase, frequency_tuning_word);
+
+        if (processed.counter != advanced.counter || processed.error[0] != advanced.error[0]
+            || processed.error[1] != advanced.error[1]) {
+            printf("FAIL advance case %d: N = %d, dac bits = %d, %s, FTW = 0x%llx, first phase = 0x%llx, "
+                   "%lld samples\n", i, N, dac_bit_depth, truncation_names[mode], frequency_tuning_word, first_phase,
+                   num_samples);
+            failures++;
+        }
+        (*num_cases)++;
+    }
+    return failures;
+}
+
+// a run split into time chunks, each pulled by a fresh context after DDS_seek, must give the times, phase, ROM and DAC
+// output of the run in one piece, the filter restarts at every chunk and is left out
+#define CHUNK_MAX_SAMPLES 12000
+#define CHUNK_MAX_CHUNKS 6
+
+typedef struct {
+    double time[CHUNK_MAX_SAMPLES];
+    long long phase[CHUNK_MAX_SAMPLES];
+    double rom_output[CHUNK_MAX_SAMPLES];
+    double dac_output[CHUNK_MAX_SAMPLES];
+} CHUNK_SAMPLES;
+
+// pulls samples first to first + count - 1 of the run into the same positions of output, returns 0 on failure
+int pull_chunk(const DDS_CONFIG *config, const REGISTERS *registers, long long first, int count,
+               CHUNK_SAMPLES *output) {
+    const char *error;
+    DDS_CONTEXT *dds = DDS_create(config, &error);
+    if (dds == NULL) {
+        printf("Error: %s.\n", error);
+        return 0;
+    }
+    DDS_set_frequency_tuning_word(dds, registers->frequency_tuning_word);
+    DDS_set_phase_register(dds, registers->phase_seed);
+    DDS_SAMPLES samples = {.time = output->time + first, .phase = output->phase + first,
+                           .dac_output = output->dac_output + first, .rom_output = output->rom_output + first};
+    int pulled = DDS_seek(dds, first) == first && DDS_pull(dds, count, &samples) == count;
+    DDS_destroy(dds);
+    return pulled;
+}
+
+int run_chunk_cases(const DDS_CONFIG *base, int count, uint64_t seed, int *num_cases) {
+    static CHUNK_SAMPLES whole, chunked;
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        DDS_CONFIG config = *base;
+        config.engine = next_random(&seed) % 4 == 0 ? DDS_ENGINE_GATE : DDS_ENGINE_WORD;
+        config.N = 1 + (int)(next_random(&seed) % 30);
+        config.dac_bit_depth = 1 + (int)(next_random(&seed) % (config.N < 16 ? config.N : 16));
+        config.phase_truncation = (PHASE_TRUNCATION_MODE)(next_random(&seed) % 4);
+        config.dither_seed = next_random(&seed);
+        config.fixed_point = next_random(&seed) % 4 == 0;
+        long long mask = (1LL << config.N) - 1;
+        REGISTERS registers = {(long long)(next_random(&seed) & mask), (long long)(next_random(&seed) & mask)};
+        int num_samples = 1 + (int)(next_random(&seed) % CHUNK_MAX_SAMPLES);
+        int num_chunks = 2 + (int)(next_random(&seed) % (CHUNK_MAX_CHUNKS - 1));
+
+        // uneven chunk boundaries, sorted, the first chunk starts at 0
+        long long starts[CHUNK_MAX_CHUNKS + 1] = {0};
+        for (int c = 1; c < num_chunks; c++) {
+            long long start = (long long)(next_random(&seed) % (uint64_t)num_samples);
+            int j = c;
+            for (; j > 1 && starts[j - 1] > start; j--) {
+                starts[j] = starts[j - 1];
+            }
+            starts[j] = start;
+        }
+        starts[num_chunks] = num_samples;
+
+        int pulled = pull_chunk(&config, &registers, 0, num_samples, &whole);
+        for (int c = 0; pulled && c < num_chunks; c++) {
+            pulled = pull_chunk(&config, &registers, starts[c], (int)(starts[c + 1] - starts[c]), &chunked);
+        }
+        if (!pulled || memcmp(whole.time, chunked.time, num_samples * sizeof(double)) != 0
+            || memcmp(whole.phase, chunked.phase, num_samples * sizeof(long long)) != 0
+            || memcmp(whole.rom_output, chunked.rom_output, num_samples * sizeof(double)) != 0
+            || memcmp(whole.dac_output, chunked.dac_output, num_samples * sizeof(double)) != 0) {
+            printf("FAIL chunk case %d: %s engine, N = %d, dac bits = %d, %s%s, FTW = 0x%llx, phase seed = 0x%llx, "
+                   "%d samples in %d chunks\n", i, DDS_engine_name(config.engine), config.N, config.dac_bit_depth,
+                   truncation_names[config.phase_truncation], config.fixed_point ? ", fixed point" : "",
+                   registers.frequency_tuning_word, registers.phase_seed, num_samples, num_chunks);
+            failures++;
+        }
+        (*num_cases)++;
+    }
+    return failures;
+}
+
+// GOLDEN CHECKSUMS -----------------------------------------------------------------------------------------------------
+typedef struct {
+    const char *name;
+    int N;
+    int dac_bit_depth;
+    double f_output;
+    bool fixed_point;
+    long long num_samples;
+    PHASE_TRUNCATION_MODE phase_truncation;
+} CANONICAL;
+
+// the configuration of the dds program and a few corners of it, tuning word derived from the output frequency
+static const CANONICAL canonical[] = {
+    {"default", 28, 10, 5e2, false, 32768, PHASE_TRUNCATE},
+    {"default_fixed_point", 28, 10, 5e2, true, 32768, PHASE_TRUNCATE},
+    {"high_frequency", 28, 12, 1.234567e6, false, 32768, PHASE_TRUNCATE},
+    {"short_accumulator", 12, 8, 1e5, false, 32768, PHASE_TRUNCATE},
+    {"full_rom", 16, 16, 7e3, true, 32768, PHASE_TRUNCATE},
+    {"dithered", 28, 10, 5e2, false, 32768, PHASE_DITHER},
+    {"noise_shaped", 20, 12, 1.1e5, false, 32768, PHASE_SHAPE_SECOND_ORDER},
+};
+
+#define NUM_CANONICAL ((int)(sizeof(canonical) / sizeof(canonical[0])))
+
+// returns the number of entries read, -1 if the file cannot be opened
+int read_golden(const char *filename, char names[][64], SIGNAL_HASHES *hashes) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[256];
+    int count = 0;
+    while (count < MAX_CANONICAL && fgets(line, sizeof(line), file) != NULL) {
+        unsigned long long phase, rom, dac, filtered;
+        if (line[0] == '#' || sscanf(line, "%63s %llx %llx %llx %llx", names[count], &phase, &rom, &dac,
+                                     &filtered) != 5) {
+            continue;
+        }
+        hashes[count] = (SIGNAL_HASHES){phase, rom, dac, filtered};
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+int write_golden(const char *filename, const SIGNAL_HASHES *hashes) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Unable to open the specified file %s.\n", filename);
+        return 0;
+    }
+    fprintf(file, "# golden checksums of the canonical configurations in regression.c, dds_regression --update\n");
+    fprintf(file, "# FNV-1a 64 over little-endian 64-bit words: the phase, and the ROM, DAC and filtered outputs\n");
+    fprintf(file, "# rounded to 2^-%d of full scale, filtered is the empty hash unless the filter is fixed point\n",
+            GOLDEN_OUTPUT_BITS);
+    fprintf(file, "# name phase rom dac filtered\n");
+    for (int i = 0; i < NUM_CANONICAL; i++) {
+        fprintf(file, "%s %016llx %016llx %016llx %016llx\n", canonical[i].name,
+                (unsigned long long)hashes[i].phase, (unsigned long long)hashes[i].rom,
+                (unsigned long long)hashes[i].dac, (unsigned long long)hashes[i].filtered);
+    }
+    fclose(file);
+    return 1;
+}
+
+int run_canonical(const DDS_CONFIG *base, bool update) {
+    char golden_names[MAX_CANONICAL][64];
+    SIGNAL_HASHES golden[MAX_CANONICAL], hashes[NUM_CANONICAL];
+    int num_golden = update ? 0 : read_golden(golden_path, golden_names, golden);
+    if (num_golden < 0) {
+        printf("FAIL golden checksums %s cannot be read, run with --update to create them\n", golden_path);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < NUM_CANONICAL; i++) {
+        DDS_CONFIG config = *base;
+        config.N = canonical[i].N;
+        config.dac_bit_depth = canonical[i].dac_bit_depth;
+        config.f_output = canonical[i].f_output;
+        config.fixed_point = canonical[i].fixed_point;
+        config.phase_truncation = canonical[i].phase_truncation;
+        REGISTERS registers = {-1, -1};
+        if (!compare_engines(canonical[i].name, config, &registers, canonical[i].num_samples, &hashes[i])) {
+            failures++;
+            continue;
+        }
+        if (update) {
+            continue;
+        }
+
+        int found = 0;
+        for (int j = 0; j < num_golden; j++) {
+            if (strcmp(golden_names[j], canonical[i].name) == 0) {
+                found = 1;
+                if (!SIGNAL_HASHES_equal(&golden[j], &hashes[i])) {
+                    printf("FAIL %s: reference engine differs from the golden checksums in", canonical[i].name);
+                    SIGNAL_HASHES_print_difference(&golden[j], &hashes[i]);
+                    failures++;
+                }
+            }
+        }
+        if (!found) {
+            printf("FAIL %s: no golden checksums in %s\n", canonical[i].name, golden_path);
+            failures++;
+        }
+    }
+
+    if (update) {
+        if (failures > 0) {
+            printf("golden checksums not written, the engines disagree\n");
+        } else if (write_golden(golden_path, hashes)) {
+            printf("golden checksums written to %s\n", golden_path);
+        } else {
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// FIXED POINT FORMATS --------------------------------------------------------------------------------------------------
+// the default formats hold one full period of the default configuration without a single overflow
+int run_overflow_check(const DDS_CONFIG *base) {
+    DDS_CONFIG config = *base;
+    config.fixed_point = true;
+    config.engine = DDS_ENGINE_WORD;
+    DDS_CONTEXT *dds = DDS_create(&config, NULL);
+    if (dds == NULL) {
+        printf("FAIL default fixed point configuration could not be created\n");
+        return 1;
+    }
+    static double dac_output[PIECE_SIZE];
+    DDS_SAMPLES samples = {.dac_output = dac_output};
+    long long period = (long long)(config.f_MCLK / config.f_output);
+    for (long long produced = 0; produced < period; produced += PIECE_SIZE) {
+        DDS_pull(dds, PIECE_SIZE, &samples);
+    }
+    FIXED_OVERFLOW_COUNTERS counters;
+    DDS_get_overflow_counters(dds, &counters);
+    DDS_destroy(dds);
+
+    if (counters.rom != 0 || counters.coefficient != 0 || counters.accumulator != 0 || counters.dac != 0) {
+        printf("FAIL default fixed point formats overflow: ROM %lld, coefficients %lld, accumulator %lld, DAC %lld\n",
+               counters.rom, counters.coefficient, counters.accumulator, counters.dac);
+        return 1;
+    }
+    return 0;
+}
+
+// GATE ACTIVITY --------------------------------------------------------------------------------------------------------
+// at a constant tuning word every flip-flop is clocked once per cycle, xor(y, Q) toggles when Q does, one cycle later
+// as Q is recorded after the edge, and the gates with a y input tied low never toggle
+int run_activity_check(const DDS_CONFIG *base) {
+    const long long frequency_tuning_word = 0x8BC;
+    DDS_CONFIG config = *base;
+    config.N = 12;
+    config.dac_bit_depth = 10;
+    config.engine = DDS_ENGINE_GATE;
+    config.gate_activity = true;
+    DDS_CONTEXT *dds = DDS_create(&config, NULL);
+    if (dds == NULL) {
+        printf("FAIL gate activity configuration could not be created\n");
+        return 1;
+    }
+    DDS_set_frequency_tuning_word(dds, frequency_tuning_word);
+    static long long phase[PIECE_SIZE];
+    DDS_SAMPLES samples = {.phase = phase};
+    long long produced = DDS_pull(dds, PIECE_SIZE, &samples);
+
+    int failures = 0;
+    const GATE_ACTIVITY *activity = DDS_get_gate_activity(dds);
+    long long cycles = activity->evaluations;
+    if (cycles < produced) {
+        printf("FAIL gate activity recorded %lld clock cycles for %lld samples\n", cycles, produced);
+        failures++;
+    }
+    const ACTIVITY_NODE tied_low[] = {ACTIVITY_NAND_YQ, ACTIVITY_NAND_Y, ACTIVITY_AND_YQ, ACTIVITY_AND_YC};
+    for (int bit = 0; bit < config.N; bit++) {
+        long long q = GATE_ACTIVITY_count(activity, ACTIVITY_Q, bit);
+        long long xor_yq = GATE_ACTIVITY_count(activity, ACTIVITY_XOR_YQ, bit);
+        long long clock = GATE_ACTIVITY_count(activity, ACTIVITY_CLOCK, bit);
+        if (clock != cycles || llabs(xor_yq - q) > 1) {
+            printf("FAIL gate activity bit %d: %lld clock edges in %lld cycles, xor_yq %lld toggles, q %lld\n", bit,
+                   clock, cycles, xor_yq, q);
+            failures++;
+        }
+        if ((frequency_tuning_word >> bit & 1) != 0) {
+            continue;
+        }
+        for (int i = 0; i < (int)(sizeof(tied_low) / sizeof(tied_low[0])); i++) {
+            if (GATE_ACTIVITY_count(activity, tied_low[i], bit) != 0) {
+                printf("FAIL gate activity bit %d: %s toggles with its y input tied low\n", bit,
+                       GATE_ACTIVITY_node_name(tied_low[i]));
+                failures++;
+            }
+        }
+    }
+    DDS_destroy(dds);
+    return failures;
+}
+
+// ACCURACY -------------------------------------------------------------------------------------------------------------
+// the recursive oscillator against cos and sin over several anchor intervals, with jumps and a jittered sample in the
+// time axis and generate calls of uneven length
+int run_oscillator_check(void) {
+    const double frequency = 1234.5678, phase_offset = 0.7, sample_rate = 1e6;
+    const long long num_samples = 3LL * OSCILLATOR_ANCHOR_INTERVAL + 5000;
+    static const int piece_sizes[] = {1, 63, 64, 65, 1000, PIECE_SIZE, 777};
+    static double time[PIECE_SIZE], in_phase[PIECE_SIZE], quadrature[PIECE_SIZE];
+
+    RECURSIVE_OSCILLATOR oscillator;
+    RECURSIVE_OSCILLATOR_init(&oscillator, frequency, phase_offset, sample_rate);
+    double worst = 0.0;
+    double skipped = 0.0;  // sample periods left out of the time axis so far
+    long long produced = 0;
+    for (int piece = 0; produced < num_samples; piece++) {
+        int count = piece_sizes[piece % (int)(sizeof(piece_sizes) / sizeof(piece_sizes[0]))];
+        if (count > num_samples - produced) count = (int)(num_samples - produced);
+        for (int k = 0; k < count; k++) {
+            long long index = produced + k;
+            if (index % 50000 == 12345) {
+                skipped += 37;
+            }
+            double jitter = index % 70000 == 54321 ? 0.5 : 0.0;
+            time[k] = (index + skipped + jitter) / sample_rate;
+        }
+        RECURSIVE_OSCILLATOR_generate(&oscillator, time, count, in_phase, quadrature);
+        for (int k = 0; k < count; k++) {
+            double phase = 2 * M_PI * fmod(frequency * time[k], 1.0) + phase_offset;
+            double error = fmax(fabs(in_phase[k] - cos(phase)), fabs(quadrature[k] - sin(phase)));
+            worst = fmax(worst, error);
+        }
+        produced += count;
+    }
+    if (worst > 2e-9) {
+        printf("FAIL recursive oscillator is %.3g away from cos and sin\n", worst);
+        return 1;
+    }
+    return 0;
+}
+
+// the sine fit of an output with known amplitude, offset, phase error and frequency offset behind a path of known
+// gain and phase shift, the tolerances leave room for the phase drift of the frequency offset within a window, which
+// the fit does not model
+int run_fit_check(void) {
+    const double frequency = 1000.0, sample_rate = 1e6, phase_offset = 0.4;
+    const double gain = 0.5, phase_shift = 0.3;
+    const double amplitude = 0.6, offset = 0.01, phase_error = 0.05, frequency_error = 0.2;
+    const int window = 1000, num_windows = 20;
+    static double time[PIECE_SIZE], in_phase[PIECE_SIZE], quadrature[PIECE_SIZE], output[PIECE_SIZE];
+
+    ERROR_METRICS metrics;
+    ERROR_METRICS_init(&metrics, 1.0, gain, phase_shift, window);
+    for (int produced = 0; produced < window * num_windows; produced += window) {
+        for (int k = 0; k < window; k++) {
+            double t = (produced + k) / sample_rate;
+            double phase = 2 * M_PI * frequency * t + phase_offset;
+            time[k] = t;
+            in_phase[k] = cos(phase);
+            quadrature[k] = sin(phase);
+            output[k] = amplitude * sin(phase + 2 * M_PI * frequency_error * t + phase_shift + phase_error) + offset;
+        }
+        ERROR_METRICS_update(&metrics, time, in_phase, quadrature, output, window);
+    }
+
+    ERROR_REPORT report;
+    ERROR_METRICS_get_report(&metrics, &report);
+    double last_window_time = ((num_windows - 1) * window + (window - 1) / 2.0) / sample_rate;
+    double expected_phase = phase_error + 2 * M_PI * frequency_error * last_window_time;
+    if (report.windows != num_windows || fabs(report.amplitude - amplitude) > 1e-5
+        || fabs(report.offset - offset) > 2e-4 || fabs(report.phase_error - expected_phase) > 2e-4
+        || fabs(report.frequency_error - frequency_error) > 1e-5) {
+        printf("FAIL sine fit: %lld windows, amplitude %.9f, offset %.9f, phase error %.9f rad (%.9f expected), "
+               "frequency error %.9f Hz\n", report.windows, report.amplitude, report.offset, report.phase_error,
+               expected_phase, report.frequency_error);
+        return 1;
+    }
+    return 0;
+}
+
+// comparator and error metrics of a run analysed at the decimated rate against the same run analysed at every sample,
+// the decimators pass the output frequency with unit gain and their group delay is part of the reference phase
+int analyse(const DDS_CONFIG *config, COMPARATOR_STATISTICS *statistics, ERROR_REPORT *report) {
+    DDS_CONTEXT *dds = DDS_create(config, NULL);
+    if (dds == NULL) {
+        return 0;
+    }
+    static double dac_output[PIECE_SIZE];
+    DDS_SAMPLES samples = {.dac_output = dac_output};
+    while (DDS_pull(dds, PIECE_SIZE, &samples) > 0) {
+    }
+    DDS_get_comparator_statistics(dds, statistics);
+    ERROR_METRICS_get_report(DDS_get_error_metrics(dds, DDS_OUTPUT_DAC), report);
+    DDS_destroy(dds);
+    return 1;
+}
+
+int run_decimated_analysis_check(const DDS_CONFIG *base) {
+    DDS_CONFIG config = *base;
+    config.engine = DDS_ENGINE_WORD;
+    config.error_metrics = true;
+    config.t_end = 10 / config.f_output;
+    COMPARATOR_STATISTICS full, decimated;
+    ERROR_REPORT full_report, decimated_report;
+    int analysed = analyse(&config, &full, &full_report);
+    config.analysis_decimation = 64;
+    analysed = analysed && analyse(&config, &decimated, &decimated_report);
+
+    if (!analysed || fabs(decimated.frequency - full.frequency) > 0.01
+        || fabs(decimated_report.rms_error - full_report.rms_error) > 5e-4
+        || fabs(decimated_report.amplitude - full_report.amplitude) > 1e-4
+        || fabs(decimated_report.frequency_error - full_report.frequency_error) > 0.01) {
+        printf("FAIL decimated analysis: square wave %.6f Hz (%.6f Hz at every sample), error %.6f V rms (%.6f V), "
+               "amplitude %.6f V (%.6f V), frequency error %.6f Hz (%.6f Hz)\n", decimated.frequency, full.frequency,
+               decimated_report.rms_error, full_report.rms_error, decimated_report.amplitude, full_report.amplitude,
+               decimated_report.frequency_error, full_report.frequency_error);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int num_random = 100;
+    uint64_t seed = 2024;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "--coefficients") == 0 && i + 1 < argc) {
+            coefficients_path = argv[++i];
+        } else if (strcmp(argv[i], "--cases") == 0 && i + 1 < argc) {
+            num_random = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else {
+            fprintf(stderr, "usage: %s [--golden FILE] [--coefficients FILE] [--cases COUNT] [--seed SEED] "
+                    "[--update]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    DDS_CONFIG base;
+    DDS_CONFIG_default(&base);
+    const char *error;
+    if (!DDS_read_coefficients(&base, coefficients_path, &error)) {
+        fprintf(stderr, "Error: %s (%s).\n", error, coefficients_path);
+        return EXIT_FAILURE;
+    }
+
+    int num_cases = 0;
+    int failures = run_edge_cases(&base, &num_cases);
+    printf("edge cases: %d of %d engine comparisons failed\n", failures, num_cases);
+
+    int num_edge_cases = num_cases;
+    int random_failures = run_random_cases(&base, num_random, seed, &num_cases);
+    printf("random cases (seed %llu): %d of %d engine comparisons failed\n", (unsigned long long)seed,
+           random_failures, num_cases - num_edge_cases);
+    failures += random_failures;
+
+    num_cases = 0;
+    int kernel_failures = run_kernel_cases(&base, seed, &num_cases);
+    printf("specialized kernels: %d of %d engine comparisons failed\n", kernel_failures, num_cases);
+    failures += kernel_failures;
+
+    num_cases = 0;
+    int advance_failures = run_advance_cases(num_random, seed, &num_cases);
+    printf("phase truncation advance: %d of %d jumps failed\n", advance_failures, num_cases);
+    failures += advance_failures;
+
+    num_cases = 0;
+    int chunk_failures = run_chunk_cases(&base, num_random, seed, &num_cases);
+    printf("runs split into time chunks: %d of %d failed\n", chunk_failures, num_cases);
+    failures += chunk_failures;
+
+    int overflow_failures = run_overflow_check(&base);
+    printf("default fixed point formats: %s\n", overflow_failures == 0 ? "no overflows" : "overflow");
+    failures += overflow_failures;
+
+    int accuracy_failures = run_oscillator_check() + run_fit_check() + run_decimated_analysis_check(&base);
+    printf("recursive oscillator, sine fit and decimated analysis: %d failed\n", accuracy_failures);
+    failures += accuracy_failures;
+
+    int activity_failures = run_activity_check(&base);
+    printf("gate activity at a constant tuning word: %d failed\n", activity_failures);
+    failures += activity_failures;
+
+    int canonical_failures = run_canonical(&base, update);
+    printf("canonical configurations: %d of %d failed\n", canonical_failures, NUM_CANONICAL);
+    failures += canonical_failures;
+
+    printf(failures == 0 ? "PASS\n" : "FAIL\n");
+    return failures == 0 ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,368 @@
+#include <stdio.h>
+#include <string.h>
+#include "shm_ring.h"
+
+#define ALIGN(size) (((size) + 63) & ~(size_t)63)  // cache line
+
+// error receives message unless it is NULL, returns 0 for the caller to pass on
+static int ring_failed(const char **error, const char *message) {
+    if (error != NULL) {
+        *error = message;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int process_alive(int64_t pid) {
+    return pid > 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+}
+
+// bytes of one slot holding block_samples samples of every signal
+static size_t slot_stride(int block_samples) {
+    return ALIGN(sizeof(SHM_RING_SLOT)
+                 + (size_t)block_samples * (3 * sizeof(double) + sizeof(long long) + sizeof(int)));
+}
+
+static SHM_RING_SLOT *get_slot(const SHM_RING *ring, uint64_t index) {
+    return (SHM_RING_SLOT *)(ring->slots + (index % ring->header->num_blocks) * ring->header->block_stride);
+}
+
+// arrays of a slot in the order time, phase, dac_output, filtered_output, square_wave
+static void slot_arrays(const SHM_RING *ring, SHM_RING_SLOT *slot, double **time, long long **phase,
+                        double **dac_output, double **filtered_output, int **square_wave) {
+    size_t n = ring->header->block_samples;
+    unsigned char *data = (unsigned char *)slot + sizeof(SHM_RING_SLOT);
+    *time = (double *)data;
+    *phase = (long long *)(data + n * sizeof(double));
+    *dac_output = (double *)(data + n * (sizeof(double) + sizeof(long long)));
+    *filtered_output = (double *)(data + n * (2 * sizeof(double) + sizeof(long long)));
+    *square_wave = (int *)(data + n * (3 * sizeof(double) + sizeof(long long)));
+}
+
+static int map(SHM_RING *ring, int flags, const char **error) {
+    ring->header = (SHM_RING_HEADER *)mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->header == MAP_FAILED) {
+        ring->header = NULL;
+        close(ring->fd);
+        if (flags & O_CREAT) shm_unlink(ring->name);
+        return ring_failed(error, "Unable to map shared memory");
+    }
+    ring->slots = (unsigned char *)ring->header + ALIGN(sizeof(SHM_RING_HEADER));
+    return 1;
+}
+
+// PRODUCER -------------------------------------------------------------------------------------------------------------
+// create (or replace) the shared memory object name, e.g. "/dds", returns 1 on success, error receives the reason of a
+// failure unless it is NULL
+int SHM_RING_create(SHM_RING *ring, const char *name, int num_blocks, int block_samples, const char **error) {
+    memset(ring, 0, sizeof(SHM_RING));
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+    ring->producer = 1;
+    ring->consumer = -1;
+
+    if (num_blocks < 2 || block_samples < 1) {
+        return ring_failed(error, "Shared memory ring needs at least 2 blocks of 1 sample");
+    }
+
+    size_t stride = slot_stride(block_samples);
+    ring->size = ALIGN(sizeof(SHM_RING_HEADER)) + (size_t)num_blocks * stride;
+
+    shm_unlink(ring->name);  // consumers of a previous run keep their mapping
+    ring->fd = shm_open(ring->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (ring->fd < 0) {
+        return ring_failed(error, "Unable to create shared memory");
+    }
+    if (ftruncate(ring->fd, (off_t)ring->size) != 0) {
+        close(ring->fd);
+        shm_unlink(ring->name);
+        return ring_failed(error, "Unable to size shared memory");
+    }
+    if (!map(ring, O_CREAT, error)) {
+        return 0;
+    }
+
+    SHM_RING_HEADER *header = ring->header;
+    header->version = SHM_RING_VERSION;
+    header->num_blocks = (uint32_t)num_blocks;
+    header->block_samples = (uint32_t)block_samples;
+    header->block_stride = stride;
+    atomic_init(&header->head, 0);
+    atomic_init(&header->closed, 0);
+    atomic_init(&header->producer_pid, (int64_t)getpid());
+    atomic_init(&header->heartbeat, monotonic_ns());
+    for (int i = 0; i < SHM_RING_MAX_CONSUMERS; i++) {
+        atomic_init(&header->consumers[i].state, SHM_RING_CONSUMER_FREE);
+        atomic_init(&header->consumers[i].pid, 0);
+    }
+    for (int i = 0; i < num_blocks; i++) {
+        atomic_init(&get_slot(ring, i)->sequence, 0);
+    }
+    atomic_store_explicit(&header->ready, 1, memory_order_release);
+    return 1;
+}
+
+// point samples at the arrays of the next slot, which consumers see as being written until it is published
+void SHM_RING_begin_block(SHM_RING *ring, DDS_SAMPLES *samples) {
+    SHM_RING_SLOT *slot = get_slot(ring, ring->position);
+    atomic_store_explicit(&slot->sequence, 2 * ring->position + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  // readers of the old block see the odd sequence before any new data
+
+    slot_arrays(ring, slot, &samples->time, &samples->phase, &samples->dac_output, &samples->filtered_output,
+                &samples->square_wave);
+    samples->sine_reference = NULL;
+}
+
+// publish the first count samples written since SHM_RING_begin_block
+void SHM_RING_publish(SHM_RING *ring, int count) {
+    SHM_RING_SLOT *slot = get_slot(ring, ring->position);
+    slot->count = (uint32_t)count;
+    atomic_store_explicit(&slot->sequence, 2 * ring->position + 2, memory_order_release);
+    ring->position++;
+    atomic_store_explicit(&ring->header->head, ring->position, memory_order_release);
+    atomic_store_explicit(&ring->header->heartbeat, monotonic_ns(), memory_order_relaxed);
+}
+
+// CONSUMER -------------------------------------------------------------------------------------------------------------
+// pass 0 takes a free record, pass 1 one whose consumer detached and pass 2 one whose consumer died without detaching,
+// an attached record always holds the pid of its owner, so exchanging the pid makes sure only one of several consumers
+// attaching at once takes over a dead one's record
+static int claim_record(SHM_RING_CONSUMER *record, int pass) {
+    int64_t pid = (int64_t)getpid();
+    if (pass < 2) {
+        uint32_t expected = pass == 0 ? SHM_RING_CONSUMER_FREE : SHM_RING_CONSUMER_DETACHED;
+        if (!atomic_compare_exchange_strong(&record->state, &expected, SHM_RING_CONSUMER_CLAIMING)) {
+            return 0;
+        }
+        atomic_store(&record->pid, pid);
+        atomic_store(&record->state, SHM_RING_CONSUMER_ATTACHED);
+        return 1;
+    }
+
+    int64_t owner = atomic_load(&record->pid);
+    return atomic_load(&record->state) == SHM_RING_CONSUMER_ATTACHED && !process_alive(owner)
+           && atomic_compare_exchange_strong(&record->pid, &owner, pid);
+}
+
+// attach to a running producer, reading starts at the next block published, returns 1 on success, error receives the
+// reason of a failure unless it is NULL
+int SHM_RING_attach(SHM_RING *ring, const char *name, const char **error) {
+    memset(ring, 0, sizeof(SHM_RING));
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+    ring->consumer = -1;
+
+    ring->fd = shm_open(ring->name, O_RDWR, 0);
+    if (ring->fd < 0) {
+        return ring_failed(error, "Unable to open shared memory");
+    }
+    struct stat status;
+    if (fstat(ring->fd, &status) != 0 || (size_t)status.st_size < ALIGN(sizeof(SHM_RING_HEADER))) {
+        close(ring->fd);
+        return ring_failed(error, "Shared memory is not initialized");
+    }
+    ring->size = (size_t)status.st_size;
+    if (!map(ring, 0, error)) {
+        return 0;
+    }
+
+    SHM_RING_HEADER *header = ring->header;
+    if (!atomic_load_explicit(&header->ready, memory_order_acquire) || header->version != SHM_RING_VERSION
+        || ALIGN(sizeof(SHM_RING_HEADER)) + (size_t)header->num_blocks * header->block_stride > ring->size) {
+        SHM_RING_close(ring);
+        return ring_failed(error, "Shared memory is not a sample ring of this version");
+    }
+
+    ring->position = atomic_load_explicit(&header->head, memory_order_acquire);
+
+    // claim a consumer record, reading works without one but is not reported to the producer
+    for (int pass = 0; pass < 3 && ring->consumer < 0; pass++) {
+        for (int i = 0; i < SHM_RING_MAX_CONSUMERS; i++) {
+            SHM_RING_CONSUMER *record = &header->consumers[i];
+            if (claim_record(record, pass)) {
+                atomic_store(&record->position, ring->position);
+                atomic_store(&record->blocks_read, 0);
+                atomic_store(&record->overruns, 0);
+                ring->consumer = i;
+                break;
+            }
+        }
+    }
+    return 1;
+}
+
+// oldest block that cannot be overwritten while it is read, the producer may be writing the one after head
+static uint64_t oldest_readable(const SHM_RING *ring, uint64_t head) {
+    uint64_t window = ring->header->num_blocks - 1;
+    return head > window ? head - window : 0;
+}
+
+static void count_overruns(SHM_RING *ring, uint64_t blocks) {
+    ring->overruns += (long long)blocks;
+    if (ring->consumer >= 0) {
+        atomic_fetch_add_explicit(&ring->header->consumers[ring->consumer].overruns, blocks, memory_order_relaxed);
+    }
+}
+
+// point block at the next published block without copying, returns 0 if none is available yet, the block must be
+// passed to SHM_RING_release once read
+int SHM_RING_acquire(SHM_RING *ring, SHM_RING_BLOCK *block) {
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&ring->header->head, memory_order_acquire);
+        if (ring->position >= head) {
+            return 0;
+        }
+
+        uint64_t oldest = oldest_readable(ring, head);
+        if (ring->position < oldest) {
+            count_overruns(ring, oldest - ring->position);
+            ring->position = oldest;
+        }
+
+        SHM_RING_SLOT *slot = get_slot(ring, ring->position);
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != 2 * ring->position + 2) {
+            count_overruns(ring, 1);  // overwritten since head was read
+            ring->position++;
+            continue;
+        }
+
+        double *time, *dac_output, *filtered_output;
+        long long *phase;
+        int *square_wave;
+        slot_arrays(ring, slot, &time, &phase, &dac_output, &filtered_output, &square_wave);
+        block->index = ring->position;
+        block->count = (int)slot->count;
+        block->time = time;
+        block->phase = phase;
+        block->dac_output = dac_output;
+        block->filtered_output = filtered_output;
+        block->square_wave = square_wave;
+        return 1;
+    }
+}
+
+// finish reading a block, returns 1 if it was intact or 0 if the producer overwrote it meanwhile, in which case
+// whatever was read from it must be discarded
+int SHM_RING_release(SHM_RING *ring, const SHM_RING_BLOCK *block) {
+    atomic_thread_fence(memory_order_acquire);  // all reads of the block happen before the sequence is checked again
+    SHM_RING_SLOT *slot = get_slot(ring, block->index);
+    int intact = atomic_load_explicit(&slot->sequence, memory_order_relaxed) == 2 * block->index + 2;
+
+    if (intact) {
+        ring->blocks_read++;
+    } else {
+        count_overruns(ring, 1);
+    }
+    ring->position = block->index + 1;
+
+    if (ring->consumer >= 0) {
+        SHM_RING_CONSUMER *record = &ring->header->consumers[ring->consumer];
+        atomic_store_explicit(&record->position, ring->position, memory_order_relaxed);
+        if (intact) atomic_fetch_add_explicit(&record->blocks_read, 1, memory_order_relaxed);
+    }
+    return intact;
+}
+
+// true once the producer has finished and every remaining block has been read
+int SHM_RING_finished(const SHM_RING *ring) {
+    return atomic_load_explicit(&ring->header->closed, memory_order_acquire)
+           && ring->position >= atomic_load_explicit(&ring->header->head, memory_order_acquire);
+}
+
+// whether the producer process still exists and has published a block within the last timeout seconds, consumers
+// waiting for blocks use it to tell a slow producer from one that died without closing the ring
+int SHM_RING_producer_alive(const SHM_RING *ring, double timeout) {
+    if (atomic_load_explicit(&ring->header->closed, memory_order_acquire)) {
+        return 1;  // finished normally, the remaining blocks are still there
+    }
+    uint64_t heartbeat = atomic_load_explicit(&ring->header->heartbeat, memory_order_relaxed);
+    uint64_t now = monotonic_ns();
+    double silence = now > heartbeat ? (double)(now - heartbeat) * 1e-9 : 0.0;
+    return process_alive(atomic_load(&ring->header->producer_pid)) && silence <= timeout;
+}
+
+// statistics consumer record index published, returns 0 if the record is not in use
+int SHM_RING_get_consumer(const SHM_RING *ring, int index, SHM_RING_CONSUMER_REPORT *report) {
+    if (ring->header == NULL || index < 0 || index >= SHM_RING_MAX_CONSUMERS) return 0;
+    const SHM_RING_CONSUMER *record = &ring->header->consumers[index];
+    uint32_t state = atomic_load(&record->state);
+    if (state == SHM_RING_CONSUMER_FREE || state == SHM_RING_CONSUMER_CLAIMING) {
+        return 0;
+    }
+    report->pid = (long long)atomic_load(&record->pid);
+    report->attached = state == SHM_RING_CONSUMER_ATTACHED && process_alive(report->pid);
+    report->blocks_read = (unsigned long long)atomic_load(&record->blocks_read);
+    report->overruns = (unsigned long long)atomic_load(&record->overruns);
+    return 1;
+}
+
+// the producer marks the ring closed and removes its name, attached consumers keep their mapping until they close
+void SHM_RING_close(SHM_RING *ring) {
+    if (ring->header != NULL) {
+        if (ring->producer) {
+            atomic_store_explicit(&ring->header->closed, 1, memory_order_release);
+            shm_unlink(ring->name);
+        } else if (ring->consumer >= 0) {
+            atomic_store(&ring->header->consumers[ring->consumer].state, SHM_RING_CONSUMER_DETACHED);
+        }
+        munmap(ring->header, ring->size);
+        close(ring->fd);
+    }
+    ring->header = NULL;
+    ring->slots = NULL;
+}
+
+#else // _WIN32
+
+int SHM_RING_create(SHM_RING *ring, const char *name, int num_blocks, int block_samples, const char **error) {
+    memset(ring, 0, sizeof(SHM_RING));
+    return ring_failed(error, "Shared memory ring requires POSIX shared memory");
+}
+
+void SHM_RING_begin_block(SHM_RING *ring, DDS_SAMPLES *samples) {
+}
+
+void SHM_RING_publish(SHM_RING *ring, int count) {
+}
+
+int SHM_RING_attach(SHM_RING *ring, const char *name, const char **error) {
+    memset(ring, 0, sizeof(SHM_RING));
+    return ring_failed(error, "Shared memory ring requires POSIX shared memory");
+}
+
+int SHM_RING_acquire(SHM_RING *ring, SHM_RING_BLOCK *block) {
+    return 0;
+}
+
+int SHM_RING_release(SHM_RING *ring, const SHM_RING_BLOCK *block) {
+    return 0;
+}
+
+int SHM_RING_finished(const SHM_RING *ring) {
+    return 1;
+}
+
+int SHM_RING_producer_alive(const SHM_RING *ring, double timeout) {
+    return 0;
+}
+
+int SHM_RING_get_consumer(const SHM_RING *ring, int index, SHM_RING_CONSUMER_REPORT *report) {
+    return 0;
+}
+
+void SHM_RING_close(SHM_RING *ring) {
+}
+
+#endif // _WIN32
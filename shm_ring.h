@@ -0,0 +1,96 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "dds.h"
+
+#define SHM_RING_VERSION 2
+#define SHM_RING_MAX_CONSUMERS 16
+
+// SHARED MEMORY LAYOUT -------------------------------------------------------------------------------------------------
+// a header followed by num_blocks slots, every slot holds one block of samples as separate arrays per signal
+// slot sequence is 2 * index + 1 while block index is being written and 2 * index + 2 once it is published (seqlock)
+
+// statistics a consumer publishes about itself, so that the producer can report them, records of consumers that
+// detached or died are reused once no free one is left
+typedef struct {
+    _Atomic uint32_t state;           // SHM_RING_CONSUMER_FREE, _CLAIMING, _ATTACHED or _DETACHED
+    _Atomic int64_t pid;
+    _Atomic uint64_t position;        // next block to read
+    _Atomic uint64_t blocks_read;     // blocks read intact
+    _Atomic uint64_t overruns;        // blocks overwritten before they could be read
+} SHM_RING_CONSUMER;
+
+enum { SHM_RING_CONSUMER_FREE, SHM_RING_CONSUMER_CLAIMING, SHM_RING_CONSUMER_ATTACHED, SHM_RING_CONSUMER_DETACHED };
+
+typedef struct {
+    _Atomic uint32_t ready;           // set once the producer has initialized the header
+    uint32_t version;
+    uint32_t num_blocks;
+    uint32_t block_samples;           // capacity of a block, samples
+    uint64_t block_stride;            // bytes per slot
+    _Atomic uint64_t head;            // number of blocks published
+    _Atomic uint32_t closed;          // producer has finished, no more blocks follow
+    _Atomic int64_t producer_pid;
+    _Atomic uint64_t heartbeat;       // monotonic clock of the last publish, ns
+    SHM_RING_CONSUMER consumers[SHM_RING_MAX_CONSUMERS];
+} SHM_RING_HEADER;
+
+typedef struct {
+    _Atomic uint64_t sequence;
+    uint32_t count;                   // samples in this block
+    uint32_t reserved;
+} SHM_RING_SLOT;
+
+// SHARED MEMORY RING BUFFER --------------------------------------------------------------------------------------------
+// single producer, multiple consumer ring of sample blocks in POSIX shared memory, lock-free on both sides: the producer
+// never waits for consumers and overwrites the oldest block, a consumer that falls behind loses blocks and counts them
+typedef struct {
+    char name[256];
+    int fd;
+    size_t size;                      // bytes mapped
+    SHM_RING_HEADER *header;
+    unsigned char *slots;
+    int producer;                     // whether this handle created the ring
+    int consumer;                     // index of consumer record, -1 if none was free
+    uint64_t position;                // next block to read (consumer) or write (producer)
+    long long blocks_read;            // blocks read intact by this consumer
+    long long overruns;               // blocks lost by this consumer
+} SHM_RING;
+
+// what a consumer record held when it was read, for the producer to report
+typedef struct {
+    long long pid;
+    int attached;                     // 0 once the consumer has detached or died
+    unsigned long long blocks_read;
+    unsigned long long overruns;
+} SHM_RING_CONSUMER_REPORT;
+
+// one published block, pointing into shared memory
+typedef struct {
+    uint64_t index;                   // block number since the producer started
+    int count;                        // samples in block
+    const double *time;
+    const long long *phase;
+    const double *dac_output;
+    const double *filtered_output;
+    const int *square_wave;
+} SHM_RING_BLOCK;
+
+// producer
+int SHM_RING_create(SHM_RING *ring, const char *name, int num_blocks, int block_samples, const char **error);
+void SHM_RING_begin_block(SHM_RING *ring, DDS_SAMPLES *samples);
+void SHM_RING_publish(SHM_RING *ring, int count);
+
+// consumer
+int SHM_RING_attach(SHM_RING *ring, const char *name, const char **error);
+int SHM_RING_acquire(SHM_RING *ring, SHM_RING_BLOCK *block);
+int SHM_RING_release(SHM_RING *ring, const SHM_RING_BLOCK *block);
+int SHM_RING_finished(const SHM_RING *ring);
+int SHM_RING_producer_alive(const SHM_RING *ring, double timeout);
+
+int SHM_RING_get_consumer(const SHM_RING *ring, int index, SHM_RING_CONSUMER_REPORT *report);
+void SHM_RING_close(SHM_RING *ring);
+
+#endif // SHM_RING_H
@@ -1,13 +1,16 @@
 # set the terminal type and output filename
 set terminal png size 1920, 1080
 
+# each envelope row holds time, min, max and mean of one pixel column,
+# written by the simulation at the pyramid level matching the plot width
+
 # Plot 1: phase accumulator
 set output 'phase_accumulator.png'
 set title "phase accumulator"
 set xlabel "time (s)"
 set ylabel "phase accumulator"
 set grid
-plot "data.txt" using 1:2 with lines linecolor rgb "blue" linewidth 2 title "phase accumulator"
+plot "envelope_phase.txt" using 1:2:3 with filledcurves linecolor rgb "blue" title "phase accumulator"
 
 # Plot 2: dac output
 set output 'dac_output.png'
@@ -15,7 +18,8 @@ set title "dac output"
 set xlabel "time (s)"
 set ylabel "voltage (v)"
 set grid
-plot "data.txt" using 1:3 with lines linecolor rgb "blue" linewidth 2 title "dac output"
+plot "envelope_dac_output.txt" using 1:2:3 with filledcurves linecolor rgb "blue" title "dac output (min/max)", \
+     "envelope_dac_output.txt" using 1:4 with lines linecolor rgb "red" linewidth 1 title "dac output (mean)"
 
 # Plot 3: square wave
 set output 'square_wave.png'
@@ -23,4 +27,4 @@ set title "square wave"
 set xlabel "time (s)"
 set ylabel "square wave (logic level)"
 set grid
-plot "data.txt" using 1:4 with lines linecolor rgb "blue" linewidth 2 title "square wave"
+plot "envelope_square_wave.txt" using 1:2:3 with filledcurves linecolor rgb "blue" title "square wave"